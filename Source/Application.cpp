@@ -7,6 +7,7 @@
 #include "ModuleGame.h"
 #include "ModuleState.h"
 #include "ModuleUI.h"
+#include "MemoryTracker.h"
 
 #include "Application.h"
 
@@ -76,9 +77,49 @@ update_status Application::Update()
 {
 	update_status ret = UPDATE_CONTINUE;
 
+	if (last_sec_frame_time.ReadSec() >= 1.0)
+	{
+		last_sec_activity = activity;
+		activity = FrameActivity();
+		last_sec_frame_time.Start();
+	}
+
+	// Menus with nothing going on run at IDLE_FPS, the iterations in between only
+	// poll input, then sleep until the next poll
+	GameState game_state = state->GetState();
+	bool in_menu = game_state == GameState::MENU_MAIN || game_state == GameState::MENU_PLAY || game_state == GameState::MENU_OPTIONS;
+
+	if (!in_menu || !power_saving || HasInput())
+		activity_time.Start();
+
+	throttled = activity_time.ReadSec() > IDLE_ACTIVE_TIME;
+
+	if (throttled)
+	{
+		double now = GetTime();
+
+		if (now < next_idle_frame)
+		{
+			WaitTime(MIN(next_idle_frame - now, IDLE_POLL_TIME));
+			PollInputEvents();
+
+			activity.skipped++;
+			return WindowShouldClose() ? UPDATE_STOP : UPDATE_CONTINUE;
+		}
+
+		next_idle_frame = now + 1.0 / IDLE_FPS;
+	}
+
+	activity.rendered++;
+	frame_count++;
+
 	deltaTime = frame_time.ReadSec();  
 	frame_time.Start();
 
+	double phase_start[PERF_PHASES + 1];
+	phase_start[PERF_PRE_UPDATE] = GetTime();
+	frame_start = phase_start[PERF_PRE_UPDATE];
+
 	for (auto it = list_modules.begin(); it != list_modules.end() && ret == UPDATE_CONTINUE; ++it)
 	{
 		Module* module = *it;
@@ -88,6 +129,8 @@ update_status Application::Update()
 		}
 	}
 
+	phase_start[PERF_UPDATE] = GetTime();
+
 	for (auto it = list_modules.begin(); it != list_modules.end() && ret == UPDATE_CONTINUE; ++it)
 	{
 		Module* module = *it;
@@ -97,6 +140,8 @@ update_status Application::Update()
 		}
 	}
 
+	phase_start[PERF_POST_UPDATE] = GetTime();
+
 	for (auto it = list_modules.begin(); it != list_modules.end() && ret == UPDATE_CONTINUE; ++it)
 	{
 		Module* module = *it;
@@ -106,6 +151,21 @@ update_status Application::Update()
 		}
 	}
 
+	phase_start[PERF_PHASES] = GetTime();
+
+	MemoryTracker::EndFrame();
+
+	if (perf.IsCapturing())
+	{
+		PerfFrame frame;
+		frame.allocs = MemoryTracker::GetFrameAllocs();
+		for (int phase = 0; phase < PERF_PHASES; ++phase)
+			frame.phase_ms[phase] = (phase_start[phase + 1] - phase_start[phase]) * 1000.0;
+		frame.frame_ms = (phase_start[PERF_PHASES] - phase_start[PERF_PRE_UPDATE]) * 1000.0;
+
+		perf.AddFrame(frame, physics->GetBodyCount(), physics->GetContactCount());
+	}
+
 	if (WindowShouldClose()) ret = UPDATE_STOP;
 
 	return ret;
@@ -123,6 +183,46 @@ bool Application::CleanUp()
 	return ret;
 }
 
+void Application::RequestFrame()
+{
+	activity_time.Start();
+}
+
+bool Application::IsThrottled() const
+{
+	return throttled;
+}
+
+double Application::GetFrameStart() const
+{
+	return frame_start;
+}
+
+const FrameActivity& Application::GetFrameActivity() const
+{
+	return last_sec_activity;
+}
+
+// Only reads the input state: GetKeyPressed() would take the key from the
+// queue before the menus see it
+bool Application::HasInput() const
+{
+	Vector2 mouse_delta = GetMouseDelta();
+
+	if (mouse_delta.x != 0.0f || mouse_delta.y != 0.0f || GetMouseWheelMove() != 0.0f ||
+		IsMouseButtonDown(MOUSE_BUTTON_LEFT) || IsMouseButtonDown(MOUSE_BUTTON_RIGHT) || IsMouseButtonReleased(MOUSE_BUTTON_LEFT) ||
+		IsWindowResized())
+		return true;
+
+	for (int key = KEY_SPACE; key <= KEY_KB_MENU; ++key)
+	{
+		if (IsKeyDown(key) || IsKeyReleased(key))
+			return true;
+	}
+
+	return false;
+}
+
 void Application::AddModule(Module* mod)
 {
 	list_modules.emplace_back(mod);
@@ -2,7 +2,9 @@
 
 #include "Globals.h"
 #include "Timer.h"
+#include "PerfCapture.h"
 #include <vector>
+#include <string>
 
 class Module;
 class ModuleWindow;
@@ -13,6 +15,16 @@ class ModuleGame;
 class ModuleState;
 class ModuleUI;
 
+#define IDLE_ACTIVE_TIME	0.5				// seconds at full rate after the last input or RequestFrame()
+#define IDLE_POLL_TIME		(1.0 / 60.0)	// longest sleep before input is polled again
+
+// Frames that ran the modules vs loop iterations that only polled input and slept
+struct FrameActivity
+{
+	uint rendered = 0;
+	uint skipped = 0;
+};
+
 class Application
 {
 public:
@@ -25,6 +37,12 @@ public:
 	ModuleState* state;
 	ModuleUI* ui;
 	float deltaTime = 0.0f;
+	bool power_saving = POWER_SAVING;
+
+	// --perf <baseline>: frame and phase times of the recorded races of every map
+	PerfCapture perf;
+	std::string perf_baseline;
+	bool perf_failed = false;
 private:
 
 	std::vector<Module*> list_modules;
@@ -34,10 +52,18 @@ private:
 	Timer startup_time;
 	Timer frame_time;
 	Timer last_sec_frame_time;
+	double frame_start = 0.0;
 
 	uint32 last_sec_frame_count = 0;
 	uint32 prev_last_sec_frame_count = 0;
 
+	// Menu idle throttling
+	Timer activity_time;
+	double next_idle_frame = 0.0;
+	bool throttled = false;
+	FrameActivity activity;
+	FrameActivity last_sec_activity;
+
 public:
 
 	Application();
@@ -47,7 +73,16 @@ public:
 	update_status Update();
 	bool CleanUp();
 
+	// Keeps the menus at full rate for a while (animations, state or audio-visual changes)
+	void RequestFrame();
+	bool IsThrottled() const;
+	const FrameActivity& GetFrameActivity() const;
+
+	// GetTime() when the running frame entered PreUpdate
+	double GetFrameStart() const;
+
 private:
 
 	void AddModule(Module* module);
+	bool HasInput() const;
 };
\ No newline at end of file
@@ -0,0 +1,213 @@
+#include "Globals.h"
+#include "AudioBank.h"
+
+#include "external/qoa.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+AudioBank::AudioBank() : header(NULL), entries(NULL)
+{
+}
+
+AudioBank::~AudioBank()
+{
+	Close();
+}
+
+bool AudioBank::Open(const char* path)
+{
+	Close();
+
+	if (!file.Open(path))
+		return false;
+
+	const AudioBankHeader* data = (const AudioBankHeader*)file.GetData();
+	unsigned long long table_end = sizeof(AudioBankHeader);
+
+	if (file.GetSize() >= sizeof(AudioBankHeader))
+		table_end += (unsigned long long)data->table_size * sizeof(AudioBankEntry);
+
+	if (file.GetSize() < table_end || data->magic != AUDIO_BANK_MAGIC || data->version != AUDIO_BANK_VERSION ||
+		data->table_size == 0 || (data->table_size & (data->table_size - 1)) != 0)
+	{
+		LOG("Invalid audio bank: %s", path);
+		file.Close();
+		return false;
+	}
+
+	header = data;
+	entries = (const AudioBankEntry*)(file.GetData() + sizeof(AudioBankHeader));
+
+	LOG("Audio bank mapped: %s (%u tracks)", path, header->entry_count);
+	return true;
+}
+
+void AudioBank::Close()
+{
+	file.Close();
+	header = NULL;
+	entries = NULL;
+}
+
+Wave AudioBank::LoadWave(const char* name) const
+{
+	const AudioBankEntry* entry = Find(name);
+
+	if (entry == NULL || entry->offset + entry->size > file.GetSize())
+		return Wave{ 0 };
+
+	return LoadWaveFromMemory(".qoa", file.GetData() + entry->offset, (int)entry->size);
+}
+
+AudioDecoder AudioBank::LoadDecoder(const char* name) const
+{
+	const AudioBankEntry* entry = Find(name);
+
+	if (entry == NULL || entry->offset + entry->size > file.GetSize())
+		return AudioDecoder{ 0 };
+
+	return LoadAudioDecoderFromMemory(".qoa", file.GetData() + entry->offset, (int)entry->size);
+}
+
+bool AudioBank::Contains(const char* name) const
+{
+	return Find(name) != NULL;
+}
+
+const AudioBankEntry* AudioBank::Find(const char* name) const
+{
+	if (header == NULL)
+		return NULL;
+
+	uint64 hash = Hash(name);
+	uint mask = header->table_size - 1;
+
+	for (uint i = 0; i < header->table_size; ++i)
+	{
+		const AudioBankEntry& entry = entries[(hash + i) & mask];
+
+		if (entry.size == 0)
+			return NULL;
+
+		if (entry.hash == hash && strncmp(entry.name, name, AUDIO_BANK_NAME_LENGTH) == 0)
+			return &entry;
+	}
+
+	return NULL;
+}
+
+bool AudioBank::Pack(const char* path, const char** files, int count)
+{
+	FilePathList scanned = { 0 };
+	std::vector<const char*> names(files, files + count);
+
+	if (names.empty())
+	{
+		scanned = LoadDirectoryFilesEx("Assets", ".wav", true);
+		names.assign(scanned.paths, scanned.paths + scanned.count);
+	}
+
+	// Half full at most keeps probe chains short
+	uint table_size = 8;
+	while (table_size < names.size() * 2) table_size *= 2;
+
+	std::vector<AudioBankEntry> table(table_size);
+	memset(table.data(), 0, table.size() * sizeof(AudioBankEntry));
+
+	std::vector<unsigned char> blobs;
+	uint64 data_start = sizeof(AudioBankHeader) + table_size * sizeof(AudioBankEntry);
+	uint packed = 0;
+	bool ok = true;
+
+	for (const char* name : names)
+	{
+		if (strlen(name) >= AUDIO_BANK_NAME_LENGTH)
+		{
+			LOG("Audio bank: name too long, skipped: %s", name);
+			continue;
+		}
+
+		Wave wave = ::LoadWave(name);
+		if (!IsWaveReady(wave))
+		{
+			LOG("Audio bank: cannot load %s", name);
+			ok = false;
+			continue;
+		}
+
+		// QOA encodes 16 bit samples
+		WaveFormat(&wave, wave.sampleRate, 16, wave.channels);
+
+		qoa_desc desc;
+		desc.channels = wave.channels;
+		desc.samplerate = wave.sampleRate;
+		desc.samples = wave.frameCount;
+
+		unsigned int size = 0;
+		unsigned char* encoded = (unsigned char*)qoa_encode((const short*)wave.data, &desc, &size);
+		UnloadWave(wave);
+
+		if (encoded == NULL)
+		{
+			LOG("Audio bank: cannot encode %s", name);
+			ok = false;
+			continue;
+		}
+
+		uint64 hash = Hash(name);
+		uint slot = (uint)(hash & (table_size - 1));
+		while (table[slot].size != 0) slot = (slot + 1) & (table_size - 1);
+
+		AudioBankEntry& entry = table[slot];
+		entry.hash = hash;
+		entry.offset = data_start + blobs.size();
+		entry.size = size;
+		strcpy(entry.name, name);
+
+		blobs.insert(blobs.end(), encoded, encoded + size);
+		MemFree(encoded);
+
+		LOG("Audio bank: %s %u -> %u bytes", name, (uint)(desc.samples * desc.channels * sizeof(short)), size);
+		packed++;
+	}
+
+	if (scanned.paths != NULL)
+		UnloadDirectoryFiles(scanned);
+
+	AudioBankHeader bank_header;
+	bank_header.magic = AUDIO_BANK_MAGIC;
+	bank_header.version = AUDIO_BANK_VERSION;
+	bank_header.entry_count = packed;
+	bank_header.table_size = table_size;
+
+	FILE* out = fopen(path, "wb");
+	if (out == NULL)
+	{
+		LOG("Audio bank: cannot write %s", path);
+		return false;
+	}
+
+	fwrite(&bank_header, sizeof(bank_header), 1, out);
+	fwrite(table.data(), sizeof(AudioBankEntry), table.size(), out);
+	if (!blobs.empty()) fwrite(blobs.data(), 1, blobs.size(), out);
+	fclose(out);
+
+	LOG("Audio bank written: %s (%u tracks, %u bytes)", path, packed, (uint)(data_start + blobs.size()));
+	return ok;
+}
+
+// FNV-1a over the path
+uint64 AudioBank::Hash(const char* name)
+{
+	uint64 hash = 14695981039346656037ULL;
+
+	for (const uchar* c = (const uchar*)name; *c != '\0'; ++c)
+	{
+		hash ^= *c;
+		hash *= 1099511628211ULL;
+	}
+
+	return hash;
+}
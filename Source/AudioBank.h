@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Globals.h"
+#include "MappedFile.h"
+
+#include "raylib.h"
+
+#define AUDIO_BANK_FILE "Assets/Audio/audio.bank"
+#define AUDIO_BANK_MAGIC 0x4B4E4241		// "ABNK"
+#define AUDIO_BANK_VERSION 1
+#define AUDIO_BANK_NAME_LENGTH 120
+
+// Bank layout: header, hash table of entries, then the encoded tracks.
+// Every track is a complete QOA file keyed by the path the game loads it with
+struct AudioBankHeader
+{
+	uint32 magic;
+	uint32 version;
+	uint32 entry_count;
+	uint32 table_size;		// power of two, open addressing with linear probing
+};
+
+struct AudioBankEntry
+{
+	uint64 hash;
+	uint64 offset;			// from the start of the bank
+	uint32 size;			// 0 marks an empty slot
+	char name[AUDIO_BANK_NAME_LENGTH];
+};
+
+// Sounds and music packed offline into one QOA encoded bank, mapped in memory
+// so only the tracks actually decoded are ever read from disk. Music decodes
+// from the mapped pages as it plays (LoadDecoder), effects are decoded whole
+// (LoadWave) since a Sound needs all its samples resident
+class AudioBank
+{
+public:
+	AudioBank();
+	~AudioBank();
+
+	bool Open(const char* path);
+	void Close();
+
+	// Decodes the track stored under this path, returns an empty wave when absent
+	Wave LoadWave(const char* name) const;
+
+	// Decoder reading the mapped track as it plays, valid while the bank is open
+	AudioDecoder LoadDecoder(const char* name) const;
+	bool Contains(const char* name) const;
+
+	// Offline: encodes every listed file (every .wav under Assets when none given)
+	static bool Pack(const char* path, const char** files, int count);
+
+private:
+	const AudioBankEntry* Find(const char* name) const;
+	static uint64 Hash(const char* name);
+
+	MappedFile file;
+	const AudioBankHeader* header;
+	const AudioBankEntry* entries;
+};
@@ -0,0 +1,117 @@
+#include "Globals.h"
+#include "Benchmark.h"
+
+#include <chrono>
+#include <stdio.h>
+
+static void ReadAllocs(uint64 allocs[MEMORY_TAGS], uint64& bytes)
+{
+	bytes = 0;
+	for (int tag = 0; tag < MEMORY_TAGS; ++tag)
+	{
+		allocs[tag] = MemoryTracker::GetStats((MemoryTag)tag).allocs;
+		bytes += MemoryTracker::GetAllocBytes((MemoryTag)tag);
+	}
+}
+
+Benchmark::Benchmark()
+{
+}
+
+Benchmark::~Benchmark()
+{
+}
+
+void Benchmark::Run(const char* name, int map, int cars, uint ops_per_iteration, const std::function<void()>& iteration)
+{
+	typedef std::chrono::steady_clock Clock;
+
+	for (int i = 0; i < BENCH_WARMUP_ITERATIONS; ++i)
+		iteration();
+
+	// Batches double until one takes long enough to trust the clock
+	uint64 batch = 1;
+	double elapsed = 0.0;
+	uint64 allocs[MEMORY_TAGS] = { 0, 0, 0 };
+	uint64 bytes = 0;
+
+	while (true)
+	{
+		uint64 allocs_before[MEMORY_TAGS], bytes_before;
+		ReadAllocs(allocs_before, bytes_before);
+		Clock::time_point start = Clock::now();
+
+		for (uint64 i = 0; i < batch; ++i)
+			iteration();
+
+		elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+		ReadAllocs(allocs, bytes);
+
+		for (int tag = 0; tag < MEMORY_TAGS; ++tag)
+			allocs[tag] -= allocs_before[tag];
+		bytes -= bytes_before;
+
+		if (elapsed >= BENCH_MIN_TIME || batch >= BENCH_MAX_ITERATIONS)
+			break;
+
+		batch *= 2;
+	}
+
+	double ops = (double)batch * (ops_per_iteration > 0 ? ops_per_iteration : 1);
+
+	BenchmarkResult result;
+	result.name = name;
+	result.map = map;
+	result.cars = cars;
+	result.iterations = batch;
+	result.ns_per_op = elapsed * 1e9 / ops;
+	result.bytes_per_op = (double)bytes / ops;
+
+	for (int tag = 0; tag < MEMORY_TAGS; ++tag)
+	{
+		result.tag_allocs_per_op[tag] = (double)allocs[tag] / ops;
+		result.allocs_per_op += result.tag_allocs_per_op[tag];
+	}
+
+	results.push_back(result);
+
+	printf("%-20s map %d cars %4d: %12.1f ns/op %8.3f allocs/op (game %.3f box2d %.3f raylib %.3f)\n", name, map, cars,
+		result.ns_per_op, result.allocs_per_op, result.tag_allocs_per_op[MEMORY_GAME],
+		result.tag_allocs_per_op[MEMORY_BOX2D], result.tag_allocs_per_op[MEMORY_RAYLIB]);
+}
+
+const std::vector<BenchmarkResult>& Benchmark::GetResults() const
+{
+	return results;
+}
+
+bool Benchmark::Save(const char* path) const
+{
+	FILE* file = fopen(path, "w");
+	if (file == NULL)
+	{
+		LOG("Cannot write benchmark results: %s", path);
+		return false;
+	}
+
+	fprintf(file, "{\n\t\"benchmarks\": [\n");
+
+	for (size_t i = 0; i < results.size(); ++i)
+	{
+		const BenchmarkResult& result = results[i];
+		fprintf(file, "\t\t{ \"name\": \"%s\", \"map\": %d, \"cars\": %d, \"iterations\": %llu, \"ns_per_op\": %.2f, \"allocs_per_op\": %.4f, \"bytes_per_op\": %.2f, \"allocs_per_op_by_tag\": { ",
+			result.name.c_str(), result.map, result.cars, (unsigned long long)result.iterations,
+			result.ns_per_op, result.allocs_per_op, result.bytes_per_op);
+
+		for (int tag = 0; tag < MEMORY_TAGS; ++tag)
+			fprintf(file, "\"%s\": %.4f%s", MemoryTracker::GetTagName((MemoryTag)tag), result.tag_allocs_per_op[tag], (tag + 1 < MEMORY_TAGS) ? ", " : "");
+
+		fprintf(file, " } }%s\n", (i + 1 < results.size()) ? "," : "");
+	}
+
+	fprintf(file, "\t]\n}\n");
+	fclose(file);
+
+	LOG("Benchmark results saved: %s", path);
+	return true;
+}
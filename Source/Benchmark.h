@@ -0,0 +1,42 @@
+#pragma once
+
+#include "Globals.h"
+#include "MemoryTracker.h"
+
+#include <vector>
+#include <string>
+#include <functional>
+
+#define BENCH_MIN_TIME 0.25			// seconds measured per case
+#define BENCH_WARMUP_ITERATIONS 8
+#define BENCH_MAX_ITERATIONS 1000000
+
+struct BenchmarkResult
+{
+	std::string name;
+	int map = 0;
+	int cars = 0;
+	uint64 iterations = 0;
+	double ns_per_op = 0.0;
+	double allocs_per_op = 0.0;				// all tags
+	double bytes_per_op = 0.0;
+	double tag_allocs_per_op[MEMORY_TAGS] = { 0.0, 0.0, 0.0 };
+};
+
+// Microbenchmark runner for --bench <file>. Every case runs until it has taken
+// BENCH_MIN_TIME, time and the MemoryTracker allocations are divided by the
+// operations one iteration performs (a car, a tire, a whole step...)
+class Benchmark
+{
+public:
+	Benchmark();
+	~Benchmark();
+
+	void Run(const char* name, int map, int cars, uint ops_per_iteration, const std::function<void()>& iteration);
+
+	const std::vector<BenchmarkResult>& GetResults() const;
+	bool Save(const char* path) const;
+
+private:
+	std::vector<BenchmarkResult> results;
+};
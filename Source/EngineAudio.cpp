@@ -0,0 +1,237 @@
+#include "Globals.h"
+#include "EngineAudio.h"
+
+#include <math.h>
+#include <string.h>
+
+EngineAudio* EngineAudio::active = NULL;
+
+EngineAudio::EngineAudio()
+{
+	stream = AudioStream{ 0 };
+
+	for (int i = 0; i < ENGINE_MAX_CARS; ++i)
+		voices[i].noise = 0x9E3779B9u ^ (uint)(i * 7919 + 1);
+}
+
+EngineAudio::~EngineAudio()
+{
+}
+
+bool EngineAudio::Init()
+{
+	stream = LoadAudioStream(ENGINE_SAMPLE_RATE, 32, 2);
+
+	if (!IsAudioStreamReady(stream))
+	{
+		LOG("Cannot create engine audio stream");
+		return false;
+	}
+
+	// raylib callbacks carry no user pointer, there is only one synth
+	active = this;
+	SetAudioStreamCallback(stream, StreamCallback);
+	PlayAudioStream(stream);
+
+	return true;
+}
+
+void EngineAudio::CleanUp()
+{
+	if (IsAudioStreamReady(stream))
+	{
+		StopAudioStream(stream);
+		UnloadAudioStream(stream);
+		stream = AudioStream{ 0 };
+	}
+
+	active = NULL;
+}
+
+// A full queue drops the update, the next frame sends fresh values anyway
+bool EngineAudio::Post(const EngineParams& params)
+{
+	if (params.car < -1 || params.car >= ENGINE_MAX_CARS)
+		return false;
+
+	if (queue.Push(params))
+		return true;
+
+	if (!queue_full_logged)
+	{
+		LOG("Engine audio queue full, updates dropped until the audio thread catches up");
+		queue_full_logged = true;
+	}
+
+	return false;
+}
+
+void EngineAudio::SilenceAll()
+{
+	EngineParams params;
+	params.car = -1;
+
+	// Unlike regular updates this one must get through
+	for (int tries = 0; tries < 100 && !queue.Push(params); ++tries)
+		WaitTime(0.001);
+}
+
+// Gearbox model: rpm climbs through each gear and drops on the shift
+float EngineAudio::RpmFromSpeed(float speed)
+{
+	float t = fabsf(speed) / ENGINE_TOP_SPEED;
+	if (t > 1.0f) t = 1.0f;
+
+	int gear = (int)(t * ENGINE_GEARS);
+	if (gear >= ENGINE_GEARS) gear = ENGINE_GEARS - 1;
+
+	float in_gear = t * ENGINE_GEARS - (float)gear;
+	float low = (gear == 0) ? 0.0f : 0.35f;
+
+	return ENGINE_IDLE_RPM + (ENGINE_MAX_RPM - ENGINE_IDLE_RPM) * (low + (1.0f - low) * in_gear);
+}
+
+void EngineAudio::StreamCallback(void* buffer, unsigned int frames)
+{
+	if (active != NULL) active->Render((float*)buffer, frames);
+	else memset(buffer, 0, frames * 2 * sizeof(float));
+}
+
+// Audio thread
+void EngineAudio::Render(float* out, uint frames)
+{
+	EngineParams params;
+	while (queue.Pop(params))
+	{
+		if (params.car == -1)
+		{
+			for (int i = 0; i < ENGINE_MAX_CARS; ++i)
+				voices[i].target.gain = 0.0f;
+		}
+		else
+		{
+			voices[params.car].target = params;
+		}
+	}
+
+	memset(out, 0, frames * 2 * sizeof(float));
+
+	// Fixed budget: only the loudest ENGINE_MIX_VOICES engines are synthesised,
+	// a voice still fading out counts by its current gain
+	int mixed[ENGINE_MIX_VOICES];
+	int mixed_count = 0;
+
+	// A voice losing its place while audible ramps to silence over this block
+	// instead of stopping on a click
+	int stolen[ENGINE_STEAL_VOICES];
+	int stolen_count = 0;
+
+	auto steal = [&](int index)
+	{
+		if (voices[index].gain > 0.0f && stolen_count < ENGINE_STEAL_VOICES)
+			stolen[stolen_count++] = index;
+		else
+			voices[index].gain = 0.0f;
+	};
+
+	for (int i = 0; i < ENGINE_MAX_CARS; ++i)
+	{
+		EngineVoice& voice = voices[i];
+		float loudness = MAX(voice.target.gain, voice.gain);
+
+		if (loudness <= 0.0001f)
+		{
+			voice.gain = 0.0f;
+			continue;
+		}
+
+		if (mixed_count < ENGINE_MIX_VOICES)
+		{
+			mixed[mixed_count++] = i;
+			continue;
+		}
+
+		int quietest = 0;
+		for (int m = 1; m < mixed_count; ++m)
+		{
+			if (MAX(voices[mixed[m]].target.gain, voices[mixed[m]].gain) < MAX(voices[mixed[quietest]].target.gain, voices[mixed[quietest]].gain))
+				quietest = m;
+		}
+
+		EngineVoice& dropped = voices[mixed[quietest]];
+		if (MAX(dropped.target.gain, dropped.gain) < loudness)
+		{
+			steal(mixed[quietest]);
+			mixed[quietest] = i;
+		}
+		else
+		{
+			steal(i);
+		}
+	}
+
+	for (int m = 0; m < mixed_count; ++m)
+		MixVoice(voices[mixed[m]], voices[mixed[m]].target.gain, out, frames);
+
+	for (int s = 0; s < stolen_count; ++s)
+		MixVoice(voices[stolen[s]], 0.0f, out, frames);
+
+	// Soft clip, many engines close together sum past 1
+	for (uint i = 0; i < frames * 2; ++i)
+	{
+		float x = out[i];
+		if (x > 3.0f) x = 3.0f;
+		else if (x < -3.0f) x = -3.0f;
+		out[i] = x * (27.0f + x * x) / (27.0f + 9.0f * x * x);
+	}
+}
+
+// One decaying pulse per cylinder firing plus throttle noise, through a one pole
+// lowpass that opens with rpm. Parameters ramp over the block to avoid zipper noise,
+// target_gain is the voice's own unless it is being stolen
+void EngineAudio::MixVoice(EngineVoice& voice, float target_gain, float* out, uint frames)
+{
+	const EngineParams& target = voice.target;
+
+	float target_freq = target.rpm / 60.0f * (ENGINE_CYLINDERS / 2.0f);
+	if (voice.freq == 0.0f) voice.freq = target_freq;
+
+	float inv_frames = 1.0f / (float)frames;
+	float freq_step = (target_freq - voice.freq) * inv_frames;
+	float gain_step = (target_gain - voice.gain) * inv_frames;
+	float pan_step = (target.pan - voice.pan) * inv_frames;
+
+	float cutoff = 0.05f + 0.25f * (target.rpm / ENGINE_MAX_RPM);
+	float noise_amount = 0.15f + 0.35f * target.throttle;
+
+	for (uint i = 0; i < frames; ++i)
+	{
+		voice.freq += freq_step;
+		voice.gain += gain_step;
+		voice.pan += pan_step;
+
+		voice.phase += voice.freq / (float)ENGINE_SAMPLE_RATE;
+		if (voice.phase >= 1.0f) voice.phase -= 1.0f;
+
+		voice.noise ^= voice.noise << 13;
+		voice.noise ^= voice.noise >> 17;
+		voice.noise ^= voice.noise << 5;
+		float noise = (float)(voice.noise & 0xFFFF) / 32768.0f - 1.0f;
+
+		float env = 1.0f - voice.phase;
+		float pulse = env * env * env - 0.25f;		// 0.25 is the mean, keeps it centred
+		float sample = pulse + noise * noise_amount * env;
+
+		voice.lowpass += (sample - voice.lowpass) * cutoff;
+
+		float s = voice.lowpass * voice.gain * ENGINE_VOLUME;
+		out[i * 2] += s * sqrtf(0.5f * (1.0f - voice.pan));
+		out[i * 2 + 1] += s * sqrtf(0.5f * (1.0f + voice.pan));
+	}
+
+	if (voice.gain <= 0.0001f)
+	{
+		voice.gain = 0.0f;
+		voice.freq = 0.0f;
+	}
+}
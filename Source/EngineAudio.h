@@ -0,0 +1,75 @@
+#pragma once
+
+#include "Globals.h"
+#include "SpscQueue.h"
+
+#include "raylib.h"
+
+#define ENGINE_SAMPLE_RATE 44100
+#define ENGINE_MAX_CARS 1024		// car ids the synth keeps state for, a full --stress race included
+#define ENGINE_MIX_VOICES 16		// loudest engines mixed per block, the rest are skipped
+#define ENGINE_QUEUE_SIZE (ENGINE_MAX_CARS * 2)	// two frames of every car, the audio thread can lag one behind
+#define ENGINE_STEAL_VOICES 16		// stolen voices ramped out per block, past it they are cut
+#define ENGINE_VOLUME 0.35f
+
+#define ENGINE_IDLE_RPM 900.0f
+#define ENGINE_MAX_RPM 7500.0f
+#define ENGINE_CYLINDERS 4
+#define ENGINE_GEARS 5
+#define ENGINE_TOP_SPEED 10.0f		// m/s mapped to the top of the last gear
+
+// Sent from the game thread every frame for each audible car.
+// car == -1 silences every engine
+struct EngineParams
+{
+	int car = -1;
+	float rpm = 0.0f;
+	float throttle = 0.0f;
+	float gain = 0.0f;			// distance attenuation and sfx volume already applied
+	float pan = 0.0f;			// -1 left, 1 right
+};
+
+// Synthesis state, only touched by the audio thread
+struct EngineVoice
+{
+	EngineParams target;
+
+	float freq = 0.0f;
+	float gain = 0.0f;
+	float pan = 0.0f;
+
+	float phase = 0.0f;
+	float lowpass = 0.0f;
+	uint noise = 1;
+};
+
+// Procedural engine sound for every car, rendered inside an AudioStream
+// callback. The game thread only posts parameters through a lock free queue,
+// all per sample work happens on the audio thread
+class EngineAudio
+{
+public:
+	EngineAudio();
+	~EngineAudio();
+
+	bool Init();
+	void CleanUp();
+
+	// Game thread
+	bool Post(const EngineParams& params);
+	void SilenceAll();
+
+	static float RpmFromSpeed(float speed);
+
+private:
+	static void StreamCallback(void* buffer, unsigned int frames);
+	void Render(float* out, uint frames);
+	void MixVoice(EngineVoice& voice, float target_gain, float* out, uint frames);
+
+	static EngineAudio* active;
+
+	AudioStream stream;
+	SpscQueue<EngineParams, ENGINE_QUEUE_SIZE> queue;
+	EngineVoice voices[ENGINE_MAX_CARS];
+	bool queue_full_logged = false;
+};
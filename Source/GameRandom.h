@@ -0,0 +1,57 @@
+#pragma once
+
+#include "Globals.h"
+
+// Seeded generator owned by the game so a race can be reproduced exactly,
+// raylib's GetRandomValue() shares its state with everything else
+class GameRandom
+{
+public:
+	GameRandom(uint32 seed = 1)
+	{
+		Seed(seed);
+	}
+
+	void Seed(uint32 value)
+	{
+		seed = value;
+		state = (value != 0) ? value : 0x9E3779B9u;
+	}
+
+	uint32 GetSeed() const
+	{
+		return seed;
+	}
+
+	uint32 GetState() const
+	{
+		return state;
+	}
+
+	// xorshift32
+	uint32 Next()
+	{
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		return state;
+	}
+
+	// Inclusive range, same contract as GetRandomValue()
+	int GetValue(int min, int max)
+	{
+		if (min > max)
+		{
+			int tmp = max;
+			max = min;
+			min = tmp;
+		}
+
+		uint32 range = (uint32)(max - min) + 1;
+		return min + (int)(Next() % range);
+	}
+
+private:
+	uint32 seed;
+	uint32 state;
+};
@@ -0,0 +1,237 @@
+#include "Globals.h"
+#include "GhostTrack.h"
+
+#include <math.h>
+#include <stdio.h>
+
+// Zigzag varint of at most 5 bytes, false when it runs past the end of the data
+static bool ReadValue(const std::vector<uchar>& data, uint& offset, int& value)
+{
+	uint32 zigzag = 0;
+
+	for (int shift = 0; shift < 35 && offset < data.size(); shift += 7)
+	{
+		uchar byte = data[offset++];
+		zigzag |= (uint32)(byte & 0x7F) << shift;
+
+		if ((byte & 0x80) == 0)
+		{
+			value = (int)(zigzag >> 1) ^ -(int)(zigzag & 1);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+GhostTrack::GhostTrack()
+{
+}
+
+GhostTrack::~GhostTrack()
+{
+}
+
+void GhostTrack::Begin(int map, const ReplayCar& lap_car)
+{
+	Clear();
+	map_id = map;
+	car = lap_car;
+	data.reserve(GHOST_RESERVED_SAMPLES * 3);
+}
+
+void GhostTrack::Record(uint32 lap_tick, const ReplayTransform& transform)
+{
+	if (lap_tick % GHOST_SAMPLE_TICKS != 0)
+		return;
+
+	int values[3] = {
+		(int)lroundf(transform.x),
+		(int)lroundf(transform.y),
+		(int)lroundf(transform.angle * REPLAY_ANGLE_SCALE)
+	};
+
+	for (int i = 0; i < 3; ++i)
+	{
+		int value = (sample_count == 0) ? values[i] : values[i] - last[i];
+		uint32 zigzag = ((uint32)value << 1) ^ (uint32)(value >> 31);
+
+		while (zigzag >= 0x80)
+		{
+			data.push_back((uchar)(zigzag | 0x80));
+			zigzag >>= 7;
+		}
+		data.push_back((uchar)zigzag);
+
+		last[i] = values[i];
+	}
+
+	sample_count++;
+}
+
+void GhostTrack::End(uint32 ticks)
+{
+	lap_ticks = ticks;
+}
+
+bool GhostTrack::Save(const char* path) const
+{
+	if (IsEmpty())
+		return false;
+
+	FILE* file = fopen(path, "wb");
+	if (file == NULL)
+	{
+		LOG("Cannot write ghost: %s", path);
+		return false;
+	}
+
+	uint32 header[6] = { GHOST_MAGIC, GHOST_VERSION, (uint32)map_id, lap_ticks, sample_count, (uint32)data.size() };
+	fwrite(header, sizeof(header), 1, file);
+	fwrite(&car, sizeof(ReplayCar), 1, file);
+	fwrite(data.data(), 1, data.size(), file);
+	fclose(file);
+
+	LOG("Ghost saved: %s (%u ticks, %u bytes)", path, lap_ticks, (uint)data.size());
+	return true;
+}
+
+bool GhostTrack::Load(const char* path)
+{
+	Clear();
+
+	FILE* file = fopen(path, "rb");
+	if (file == NULL)
+		return false;
+
+	fseek(file, 0, SEEK_END);
+	long file_size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	uint32 header[6] = { 0 };
+	bool ok = fread(header, sizeof(header), 1, file) == 1 && header[0] == GHOST_MAGIC && header[1] == GHOST_VERSION;
+
+	// The samples fill the rest of the file, checked before sizing anything from the header
+	ok = ok && header[4] > 0 && (uint64)header[5] == (uint64)file_size - sizeof(header) - sizeof(ReplayCar);
+
+	if (ok)
+	{
+		data.resize(header[5]);
+		ok = fread(&car, sizeof(ReplayCar), 1, file) == 1 && fread(data.data(), 1, data.size(), file) == data.size();
+	}
+
+	fclose(file);
+
+	// Every sample must decode and use the data up to its last byte
+	uint offset = 0;
+	for (uint64 i = 0; ok && i < (uint64)header[4] * 3; ++i)
+	{
+		int value;
+		ok = ReadValue(data, offset, value);
+	}
+
+	if (!ok || offset != data.size())
+	{
+		LOG("Invalid ghost: %s", path);
+		Clear();
+		return false;
+	}
+
+	map_id = (int)header[2];
+	lap_ticks = header[3];
+	sample_count = header[4];
+	return true;
+}
+
+void GhostTrack::Clear()
+{
+	car = ReplayCar();
+	map_id = 0;
+	lap_ticks = 0;
+	sample_count = 0;
+	data.clear();
+	Rewind();
+}
+
+bool GhostTrack::IsEmpty() const
+{
+	return sample_count == 0 || lap_ticks == 0;
+}
+
+int GhostTrack::GetMapId() const
+{
+	return map_id;
+}
+
+uint32 GhostTrack::GetLapTicks() const
+{
+	return lap_ticks;
+}
+
+const ReplayCar& GhostTrack::GetCar() const
+{
+	return car;
+}
+
+uint GhostTrack::GetByteSize() const
+{
+	return (uint)data.size();
+}
+
+bool GhostTrack::Sample(float lap_tick, ReplayTransform& out)
+{
+	if (sample_count == 0 || lap_tick < 0.0f || lap_tick > (float)lap_ticks)
+		return false;
+
+	float position = lap_tick / (float)GHOST_SAMPLE_TICKS;
+	uint32 target = (uint32)position + 1;
+	float t = position - (float)(target - 1);
+
+	if (target >= sample_count)
+	{
+		target = sample_count - 1;
+		t = 1.0f;
+	}
+
+	// A new lap starts the ghost again
+	if (cursor == 0 || cursor > target + 1)
+		Rewind();
+
+	while (cursor <= target)
+		DecodeNext();
+
+	const int* a = (target > 0) ? previous : current;
+	const int* b = current;
+
+	out.x = a[0] + (b[0] - a[0]) * t;
+	out.y = a[1] + (b[1] - a[1]) * t;
+	out.angle = (a[2] + (b[2] - a[2]) * t) / REPLAY_ANGLE_SCALE;
+	out.steer = 0.0f;
+
+	return true;
+}
+
+void GhostTrack::Rewind()
+{
+	cursor = 0;
+	cursor_offset = 0;
+	for (int i = 0; i < 3; ++i)
+		current[i] = previous[i] = 0;
+}
+
+// Moves the cursor one sample forward, cursor counts the samples decoded so far.
+// Past the last sample or the end of the data the cursor still moves, holding the position
+void GhostTrack::DecodeNext()
+{
+	for (int i = 0; i < 3; ++i)
+	{
+		int delta = 0;
+		if (cursor < sample_count)
+			ReadValue(data, cursor_offset, delta);
+
+		previous[i] = current[i];
+		current[i] += delta;
+	}
+
+	cursor++;
+}
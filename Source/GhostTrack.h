@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Globals.h"
+#include "RaceReplay.h"
+
+#include <vector>
+
+#define GHOST_BEST_FILE "Best.ghost"		// inside the map folder, next to Map.txt
+#define GHOST_EXTENSION ".ghost"
+#define GHOST_MAGIC 0x54534847				// "GHST"
+#define GHOST_VERSION 1
+#define GHOST_SAMPLE_TICKS 2
+#define GHOST_MAX_LOADED 8
+#define GHOST_ALPHA 110
+#define GHOST_RESERVED_SAMPLES (120 * 30)	// two minute lap reserved by Begin()
+
+// One lap of one car: pixel positions and mrad headings, the first sample
+// absolute and zigzag varint deltas after it. Playback walks the samples
+// forward, so a ghost costs a few bytes of decoding per frame
+class GhostTrack
+{
+public:
+	GhostTrack();
+	~GhostTrack();
+
+	// Recording, ticks are relative to the start of the lap
+	void Begin(int map_id, const ReplayCar& lap_car);
+	void Record(uint32 lap_tick, const ReplayTransform& transform);
+	void End(uint32 lap_ticks);
+
+	bool Save(const char* path) const;
+	bool Load(const char* path);
+	void Clear();
+
+	bool IsEmpty() const;
+	int GetMapId() const;
+	uint32 GetLapTicks() const;
+	const ReplayCar& GetCar() const;
+	uint GetByteSize() const;
+
+	// Interpolated transform at a lap tick, false past the end of the lap
+	bool Sample(float lap_tick, ReplayTransform& out);
+
+private:
+	void Rewind();
+	void DecodeNext();
+
+	ReplayCar car;
+	int map_id = 0;
+	uint32 lap_ticks = 0;
+	uint32 sample_count = 0;
+	std::vector<uchar> data;
+
+	int last[3] = { 0, 0, 0 };			// recorder: previous sample
+
+	// Playback cursor: current sample and the one before it
+	uint32 cursor = 0;
+	uint cursor_offset = 0;
+	int current[3] = { 0, 0, 0 };
+	int previous[3] = { 0, 0, 0 };
+};
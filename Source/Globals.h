@@ -38,4 +38,6 @@ enum update_status
 #define WIN_BORDERLESS		false
 #define WIN_FULLSCREEN_DESKTOP false
 #define VSYNC				true
+#define POWER_SAVING		true	// throttle menus while nothing happens
+#define IDLE_FPS			20
 #define TITLE "Physics 2D Playground"
\ No newline at end of file
@@ -0,0 +1,139 @@
+#include "Globals.h"
+#include "InputLog.h"
+
+#include <stdio.h>
+
+InputLog::InputLog()
+{
+}
+
+InputLog::~InputLog()
+{
+}
+
+void InputLog::Begin(uint32 race_seed, int map)
+{
+	records.clear();
+	records.reserve(INPUT_LOG_RESERVED_RECORDS);
+	seed = race_seed;
+	map_id = map;
+	tick_count = 0;
+	Rewind();
+}
+
+void InputLog::Record(uint32 tick, uint32 buttons)
+{
+	if (records.empty() || records.back().buttons != buttons)
+		records.push_back(InputRecord{ tick, buttons });
+
+	tick_count = tick + 1;
+}
+
+void InputLog::End(uint32 tick)
+{
+	tick_count = tick;
+}
+
+void InputLog::Rewind()
+{
+	cursor = 0;
+	current = 0;
+}
+
+uint32 InputLog::GetButtons(uint32 tick)
+{
+	while (cursor < records.size() && records[cursor].tick <= tick)
+		current = records[cursor++].buttons;
+
+	return current;
+}
+
+bool InputLog::IsFinished(uint32 tick) const
+{
+	return tick >= tick_count;
+}
+
+bool InputLog::Save(const char* path) const
+{
+	FILE* file = fopen(path, "wb");
+	if (file == NULL)
+	{
+		LOG("Cannot write input log: %s", path);
+		return false;
+	}
+
+	Header header;
+	header.magic = INPUT_LOG_MAGIC;
+	header.version = INPUT_LOG_VERSION;
+	header.seed = seed;
+	header.map_id = map_id;
+	header.tick_count = tick_count;
+	header.record_count = (uint32)records.size();
+
+	fwrite(&header, sizeof(header), 1, file);
+	if (!records.empty()) fwrite(records.data(), sizeof(InputRecord), records.size(), file);
+	fclose(file);
+
+	LOG("Input log saved: %s (%u ticks, %u changes)", path, tick_count, header.record_count);
+	return true;
+}
+
+bool InputLog::Load(const char* path, int map_count)
+{
+	FILE* file = fopen(path, "rb");
+	if (file == NULL)
+	{
+		LOG("Cannot open input log: %s", path);
+		return false;
+	}
+
+	fseek(file, 0, SEEK_END);
+	long file_size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	Header header;
+	bool ok = fread(&header, sizeof(header), 1, file) == 1 &&
+		header.magic == INPUT_LOG_MAGIC && header.version == INPUT_LOG_VERSION &&
+		header.map_id >= 1 && header.map_id <= map_count;
+
+	// The records fill the rest of the file, checked before sizing anything from the header
+	ok = ok && (uint64)header.record_count * sizeof(InputRecord) == (uint64)file_size - sizeof(header);
+
+	if (ok)
+	{
+		records.resize(header.record_count);
+		ok = header.record_count == 0 || fread(records.data(), sizeof(InputRecord), records.size(), file) == records.size();
+	}
+
+	fclose(file);
+
+	if (!ok)
+	{
+		LOG("Invalid input log: %s", path);
+		records.clear();
+		return false;
+	}
+
+	seed = header.seed;
+	map_id = header.map_id;
+	tick_count = header.tick_count;
+	Rewind();
+
+	LOG("Input log loaded: %s (%u ticks)", path, tick_count);
+	return true;
+}
+
+uint32 InputLog::GetSeed() const
+{
+	return seed;
+}
+
+int InputLog::GetMapId() const
+{
+	return map_id;
+}
+
+uint32 InputLog::GetTickCount() const
+{
+	return tick_count;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "Globals.h"
+
+#include <vector>
+
+#define INPUT_LOG_FILE "last_race.input"
+#define INPUT_LOG_MAGIC 0x474C4E49		// "INLG"
+#define INPUT_LOG_VERSION 1
+#define INPUT_LOG_RESERVED_RECORDS 8192	// button changes reserved by Begin()
+
+enum InputButton
+{
+	INPUT_THROTTLE = 1 << 0,
+	INPUT_BRAKE = 1 << 1,
+	INPUT_BOOST = 1 << 2,
+	INPUT_LEFT = 1 << 3,
+	INPUT_RIGHT = 1 << 4
+};
+
+// Button state from this tick on, only changes are stored
+struct InputRecord
+{
+	uint32 tick;
+	uint32 buttons;
+};
+
+// Player input of one race keyed by physics tick, plus what is needed to set
+// the race up again (map and RNG seed). Replaying it through the fixed step
+// reproduces the race exactly
+class InputLog
+{
+public:
+	InputLog();
+	~InputLog();
+
+	void Begin(uint32 seed, int map_id);
+	void Record(uint32 tick, uint32 buttons);
+	void End(uint32 tick);
+
+	// Replay: ticks must be asked in increasing order
+	void Rewind();
+	uint32 GetButtons(uint32 tick);
+	bool IsFinished(uint32 tick) const;
+
+	bool Save(const char* path) const;
+	bool Load(const char* path, int map_count);	// map ids outside 1..map_count are invalid
+
+	uint32 GetSeed() const;
+	int GetMapId() const;
+	uint32 GetTickCount() const;
+
+private:
+	struct Header
+	{
+		uint32 magic;
+		uint32 version;
+		uint32 seed;
+		int map_id;
+		uint32 tick_count;
+		uint32 record_count;
+	};
+
+	std::vector<InputRecord> records;
+	uint32 seed = 0;
+	int map_id = 1;
+	uint32 tick_count = 0;
+
+	uint cursor = 0;
+	uint32 current = 0;
+};
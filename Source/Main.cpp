@@ -1,9 +1,16 @@
 #include "Application.h"
 #include "Globals.h"
+#include "AudioBank.h"
+#include "MemoryTracker.h"
+#include "ModuleGame.h"
+#include "ModulePhysics.h"
+#include "ModuleWindow.h"
+#include "StateTrace.h"
 
 #include "raylib.h"
 
 #include <stdlib.h>
+#include <string.h>
 
 enum main_states
 {
@@ -16,6 +23,21 @@ enum main_states
 
 int main(int argc, char ** argv)
 {
+	MemoryTracker::Install();
+
+	// Offline audio packing: --pack-audio [bank] [files...]
+	if (argc > 1 && strcmp(argv[1], "--pack-audio") == 0)
+	{
+		const char* bank_path = (argc > 2) ? argv[2] : AUDIO_BANK_FILE;
+		int count = (argc > 3) ? argc - 3 : 0;
+
+		return AudioBank::Pack(bank_path, (const char**)(argv + 3), count) ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	// Determinism check between two --trace runs: --compare-trace <a> <b>
+	if (argc > 3 && strcmp(argv[1], "--compare-trace") == 0)
+		return StateTrace::Compare(argv[2], argv[3]) ? EXIT_SUCCESS : EXIT_FAILURE;
+
 	LOG("Starting game '%s'...", TITLE);
 
 	int main_return = EXIT_FAILURE;
@@ -30,6 +52,34 @@ int main(int argc, char ** argv)
 
 			LOG("-------------- Application Creation --------------");
 			App = new Application();
+
+			// --replay <file> re-feeds a recorded input log (see INPUT_LOG_FILE)
+			for (int i = 1; i + 1 < argc; ++i)
+			{
+				if (strcmp(argv[i], "--replay") == 0)
+					App->scene_intro->replay_file = argv[i + 1];
+				else if (strcmp(argv[i], "--trace") == 0)
+					App->physics->trace_file = argv[i + 1];
+				else if (strcmp(argv[i], "--telemetry") == 0)
+					App->scene_intro->telemetry_file = argv[i + 1];
+				else if (strcmp(argv[i], "--bench") == 0)
+					App->scene_intro->bench_file = argv[i + 1];
+				else if (strcmp(argv[i], "--stress") == 0)
+					App->scene_intro->stress.cars = atoi(argv[i + 1]);
+				else if (strcmp(argv[i], "--stress-debris") == 0)
+					App->scene_intro->stress.debris = atoi(argv[i + 1]);
+				else if (strcmp(argv[i], "--stress-off") == 0)
+				{
+					if (!App->scene_intro->stress.Disable(argv[i + 1]))
+						LOG("Unknown subsystem for --stress-off: %s", argv[i + 1]);
+				}
+				else if (strcmp(argv[i], "--perf") == 0)
+				{
+					App->perf_baseline = argv[i + 1];
+					App->window->vsync = false;
+				}
+			}
+
 			state = MAIN_START;
 			break;
 
@@ -71,7 +121,7 @@ int main(int argc, char ** argv)
 			{
 				LOG("Application CleanUp exits with ERROR");
 			}
-			else
+			else if (!App->perf_failed)
 				main_return = EXIT_SUCCESS;
 
 			state = MAIN_EXIT;
@@ -0,0 +1,116 @@
+#include "MappedFile.h"
+
+#if defined(_WIN32)
+	#define WIN32_LEAN_AND_MEAN
+	#define NOMINMAX
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+MappedFile::MappedFile() : data(nullptr), size(0), file(nullptr), mapping(nullptr)
+{
+}
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+bool MappedFile::Open(const char* path)
+{
+	Close();
+
+#if defined(_WIN32)
+	HANDLE handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, NULL);
+	if (handle == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER file_size;
+	if (!GetFileSizeEx(handle, &file_size) || file_size.QuadPart == 0)
+	{
+		CloseHandle(handle);
+		return false;
+	}
+
+	HANDLE map = CreateFileMappingA(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (map == NULL)
+	{
+		CloseHandle(handle);
+		return false;
+	}
+
+	void* view = MapViewOfFile(map, FILE_MAP_READ, 0, 0, 0);
+	if (view == NULL)
+	{
+		CloseHandle(map);
+		CloseHandle(handle);
+		return false;
+	}
+
+	file = handle;
+	mapping = map;
+	data = (const unsigned char*)view;
+	size = (unsigned long long)file_size.QuadPart;
+#else
+	int fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat info;
+	if (fstat(fd, &info) != 0 || info.st_size == 0)
+	{
+		close(fd);
+		return false;
+	}
+
+	void* view = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+
+	if (view == MAP_FAILED)
+		return false;
+
+	mapping = view;
+	data = (const unsigned char*)view;
+	size = (unsigned long long)info.st_size;
+#endif
+
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (data == nullptr)
+		return;
+
+#if defined(_WIN32)
+	UnmapViewOfFile(data);
+	CloseHandle((HANDLE)mapping);
+	CloseHandle((HANDLE)file);
+#else
+	munmap(mapping, (size_t)size);
+#endif
+
+	data = nullptr;
+	size = 0;
+	file = nullptr;
+	mapping = nullptr;
+}
+
+const unsigned char* MappedFile::GetData() const
+{
+	return data;
+}
+
+unsigned long long MappedFile::GetSize() const
+{
+	return size;
+}
+
+bool MappedFile::IsOpen() const
+{
+	return data != nullptr;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+// Read only view of a whole file mapped into memory.
+// Kept apart from Globals.h: the platform headers clash with raylib names
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	bool Open(const char* path);
+	void Close();
+
+	const unsigned char* GetData() const;
+	unsigned long long GetSize() const;
+	bool IsOpen() const;
+
+private:
+	const unsigned char* data;
+	unsigned long long size;
+
+	void* file;
+	void* mapping;
+};
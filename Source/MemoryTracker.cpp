@@ -0,0 +1,283 @@
+#include "Globals.h"
+#include "MemoryTracker.h"
+
+#include "box2d/b2_settings.h"
+
+#include <atomic>
+#include <new>
+#include <stdlib.h>
+
+// _msize() does not take _aligned_malloc() blocks, the aligned size has its own call
+#if defined(_WIN32)
+	#include <malloc.h>
+	#define USABLE_SIZE(ptr) _msize(ptr)
+	#define ALIGNED_USABLE_SIZE(ptr, alignment) _aligned_msize(ptr, alignment, 0)
+#elif defined(__APPLE__)
+	#include <malloc/malloc.h>
+	#define USABLE_SIZE(ptr) malloc_size(ptr)
+	#define ALIGNED_USABLE_SIZE(ptr, alignment) malloc_size(ptr)
+#else
+	#include <malloc.h>
+	#define USABLE_SIZE(ptr) malloc_usable_size(ptr)
+	#define ALIGNED_USABLE_SIZE(ptr, alignment) malloc_usable_size(ptr)
+#endif
+
+// Constant-initialized, operator new runs before main() does
+struct TagCounters
+{
+	std::atomic<unsigned long long> live_bytes;
+	std::atomic<unsigned long long> peak_bytes;
+	std::atomic<unsigned long long> allocs;
+	std::atomic<unsigned long long> alloc_bytes;
+	std::atomic<unsigned int> frame_allocs;
+	std::atomic<unsigned int> last_frame_allocs;
+};
+
+static TagCounters counters[MEMORY_TAGS];
+static const char* tag_names[MEMORY_TAGS] = { "game", "box2d", "raylib" };
+static const unsigned long long tag_budgets[MEMORY_TAGS] = { MEMORY_BUDGET_GAME, MEMORY_BUDGET_BOX2D, MEMORY_BUDGET_RAYLIB };
+static bool over_budget[MEMORY_TAGS] = { false, false, false };
+
+static void CountAlloc(MemoryTag tag, size_t usable, size_t requested)
+{
+	TagCounters& tag_counters = counters[tag];
+	unsigned long long size = (unsigned long long)usable;
+
+	tag_counters.allocs.fetch_add(1, std::memory_order_relaxed);
+	tag_counters.alloc_bytes.fetch_add(requested, std::memory_order_relaxed);
+	tag_counters.frame_allocs.fetch_add(1, std::memory_order_relaxed);
+
+	unsigned long long live = tag_counters.live_bytes.fetch_add(size, std::memory_order_relaxed) + size;
+	unsigned long long peak = tag_counters.peak_bytes.load(std::memory_order_relaxed);
+	while (live > peak && !tag_counters.peak_bytes.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+	{
+	}
+}
+
+static void CountFree(MemoryTag tag, size_t usable)
+{
+	counters[tag].live_bytes.fetch_sub((unsigned long long)usable, std::memory_order_relaxed);
+}
+
+// Global operator new: the game tag ---------------
+void* operator new(size_t size)
+{
+	void* ptr = MemoryTracker::Alloc(MEMORY_GAME, size ? size : 1);
+	if (ptr == NULL) throw std::bad_alloc();
+	return ptr;
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept
+{
+	MemoryTracker::Free(MEMORY_GAME, ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+	MemoryTracker::Free(MEMORY_GAME, ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+	MemoryTracker::Free(MEMORY_GAME, ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept
+{
+	MemoryTracker::Free(MEMORY_GAME, ptr);
+}
+
+// Over-aligned types (alignas(64) queues) come through these
+void* operator new(size_t size, std::align_val_t alignment)
+{
+	void* ptr = MemoryTracker::AllocAligned(MEMORY_GAME, size ? size : 1, (size_t)alignment);
+	if (ptr == NULL) throw std::bad_alloc();
+	return ptr;
+}
+
+void* operator new[](size_t size, std::align_val_t alignment)
+{
+	return operator new(size, alignment);
+}
+
+void operator delete(void* ptr, std::align_val_t alignment) noexcept
+{
+	MemoryTracker::FreeAligned(MEMORY_GAME, ptr, (size_t)alignment);
+}
+
+void operator delete[](void* ptr, std::align_val_t alignment) noexcept
+{
+	MemoryTracker::FreeAligned(MEMORY_GAME, ptr, (size_t)alignment);
+}
+
+void operator delete(void* ptr, size_t, std::align_val_t alignment) noexcept
+{
+	MemoryTracker::FreeAligned(MEMORY_GAME, ptr, (size_t)alignment);
+}
+
+void operator delete[](void* ptr, size_t, std::align_val_t alignment) noexcept
+{
+	MemoryTracker::FreeAligned(MEMORY_GAME, ptr, (size_t)alignment);
+}
+
+// Library hooks -----------------------------------
+static void* Box2DAlloc(int32 size)
+{
+	return MemoryTracker::Alloc(MEMORY_BOX2D, (size_t)size);
+}
+
+static void Box2DFree(void* mem)
+{
+	MemoryTracker::Free(MEMORY_BOX2D, mem);
+}
+
+static void* RaylibAlloc(size_t size)
+{
+	return MemoryTracker::Alloc(MEMORY_RAYLIB, size);
+}
+
+static void* RaylibRealloc(void* ptr, size_t size)
+{
+	return MemoryTracker::Realloc(MEMORY_RAYLIB, ptr, size);
+}
+
+static void RaylibFree(void* ptr)
+{
+	MemoryTracker::Free(MEMORY_RAYLIB, ptr);
+}
+
+// Before the window opens: blocks raylib or Box2D allocated earlier would be
+// freed without having been counted
+void MemoryTracker::Install()
+{
+	b2SetAllocator(Box2DAlloc, Box2DFree);
+	SetMemoryCallbacks(RaylibAlloc, RaylibRealloc, RaylibFree);
+}
+
+void* MemoryTracker::Alloc(MemoryTag tag, size_t size)
+{
+	void* ptr = malloc(size);
+	if (ptr != NULL) CountAlloc(tag, USABLE_SIZE(ptr), size);
+	return ptr;
+}
+
+// Windows needs the matching _aligned_free(), elsewhere free() takes the block
+void* MemoryTracker::AllocAligned(MemoryTag tag, size_t size, size_t alignment)
+{
+	void* ptr = NULL;
+#if defined(_WIN32)
+	ptr = _aligned_malloc(size, alignment);
+#else
+	if (posix_memalign(&ptr, alignment, size) != 0) ptr = NULL;
+#endif
+	if (ptr != NULL) CountAlloc(tag, ALIGNED_USABLE_SIZE(ptr, alignment), size);
+	return ptr;
+}
+
+void MemoryTracker::FreeAligned(MemoryTag tag, void* ptr, size_t alignment)
+{
+	if (ptr == NULL)
+		return;
+
+	CountFree(tag, ALIGNED_USABLE_SIZE(ptr, alignment));
+#if defined(_WIN32)
+	_aligned_free(ptr);
+#else
+	free(ptr);
+#endif
+}
+
+void* MemoryTracker::Realloc(MemoryTag tag, void* ptr, size_t size)
+{
+	if (ptr == NULL)
+		return Alloc(tag, size);
+
+	// realloc() to zero may free the block or return a new one, do it explicitly
+	if (size == 0)
+	{
+		Free(tag, ptr);
+		return NULL;
+	}
+
+	size_t old_size = USABLE_SIZE(ptr);
+	void* result = realloc(ptr, size);
+	if (result == NULL)
+		return NULL;
+
+	counters[tag].live_bytes.fetch_sub(old_size, std::memory_order_relaxed);
+	CountAlloc(tag, USABLE_SIZE(result), size);
+	return result;
+}
+
+void MemoryTracker::Free(MemoryTag tag, void* ptr)
+{
+	if (ptr == NULL)
+		return;
+
+	CountFree(tag, USABLE_SIZE(ptr));
+	free(ptr);
+}
+
+void MemoryTracker::EndFrame()
+{
+	for (int tag = 0; tag < MEMORY_TAGS; ++tag)
+	{
+		unsigned int frame_allocs = counters[tag].frame_allocs.exchange(0, std::memory_order_relaxed);
+		counters[tag].last_frame_allocs.store(frame_allocs, std::memory_order_relaxed);
+
+		if (!over_budget[tag] && counters[tag].live_bytes.load(std::memory_order_relaxed) > tag_budgets[tag])
+		{
+			over_budget[tag] = true;
+			LOG("Memory budget of %s exceeded: %.1f MB", tag_names[tag], tag_budgets[tag] / (1024.0 * 1024.0));
+		}
+	}
+}
+
+// The overlay peak restarts too, a --perf run reports its own
+void MemoryTracker::ResetPeaks()
+{
+	for (int tag = 0; tag < MEMORY_TAGS; ++tag)
+		counters[tag].peak_bytes.store(counters[tag].live_bytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+MemoryStats MemoryTracker::GetStats(MemoryTag tag)
+{
+	const TagCounters& tag_counters = counters[tag];
+
+	MemoryStats stats;
+	stats.live_bytes = tag_counters.live_bytes.load(std::memory_order_relaxed);
+	stats.peak_bytes = tag_counters.peak_bytes.load(std::memory_order_relaxed);
+	stats.allocs = tag_counters.allocs.load(std::memory_order_relaxed);
+	stats.frame_allocs = tag_counters.last_frame_allocs.load(std::memory_order_relaxed);
+
+	return stats;
+}
+
+unsigned int MemoryTracker::GetFrameAllocs()
+{
+	unsigned int total = 0;
+	for (int tag = 0; tag < MEMORY_TAGS; ++tag)
+		total += counters[tag].last_frame_allocs.load(std::memory_order_relaxed);
+
+	return total;
+}
+
+unsigned long long MemoryTracker::GetAllocBytes(MemoryTag tag)
+{
+	return counters[tag].alloc_bytes.load(std::memory_order_relaxed);
+}
+
+unsigned long long MemoryTracker::GetBudget(MemoryTag tag)
+{
+	return tag_budgets[tag];
+}
+
+const char* MemoryTracker::GetTagName(MemoryTag tag)
+{
+	return tag_names[tag];
+}
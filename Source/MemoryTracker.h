@@ -0,0 +1,56 @@
+#pragma once
+
+#include <stddef.h>
+
+// Live bytes each tag should stay under in a full race, past them the debug
+// overlay shows the tag in red and EndFrame() logs it once
+#define MEMORY_BUDGET_GAME		(64ull * 1024 * 1024)
+#define MEMORY_BUDGET_BOX2D		(16ull * 1024 * 1024)
+#define MEMORY_BUDGET_RAYLIB	(256ull * 1024 * 1024)
+
+enum MemoryTag
+{
+	MEMORY_GAME = 0,		// global operator new: entities, containers, strings
+	MEMORY_BOX2D,			// b2Alloc: block and stack allocators, broad-phase
+	MEMORY_RAYLIB,			// RL_MALLOC: images, meshes, audio buffers, file data
+	MEMORY_TAGS
+};
+
+struct MemoryStats
+{
+	unsigned long long live_bytes = 0;
+	unsigned long long peak_bytes = 0;
+	unsigned long long allocs = 0;			// since the process started
+	unsigned int frame_allocs = 0;			// during the last finished frame
+};
+
+// Tagged allocation counters for the game, Box2D and raylib. The game tag is
+// always on through the global operator new, Install() routes the other two
+// libraries here. Sizes come from the C runtime (usable size of the block), so
+// blocks carry no header and one freed by the wrong allocator cannot crash.
+// Kept free of raylib names, PerfCapture includes it without Globals.h
+class MemoryTracker
+{
+public:
+	static void Install();
+
+	static void* Alloc(MemoryTag tag, size_t size);
+	static void* Realloc(MemoryTag tag, void* ptr, size_t size);
+	static void Free(MemoryTag tag, void* ptr);
+
+	// Blocks from AllocAligned() go back through FreeAligned() with the same alignment
+	static void* AllocAligned(MemoryTag tag, size_t size, size_t alignment);
+	static void FreeAligned(MemoryTag tag, void* ptr, size_t alignment);
+
+	// Closes the frame counters, called once per rendered frame
+	static void EndFrame();
+
+	// Starts every tag's peak again from its live bytes, for per-run high-water marks
+	static void ResetPeaks();
+
+	static MemoryStats GetStats(MemoryTag tag);
+	static unsigned int GetFrameAllocs();			// all tags, last finished frame
+	static unsigned long long GetAllocBytes(MemoryTag tag);	// requested bytes since the process started
+	static unsigned long long GetBudget(MemoryTag tag);
+	static const char* GetTagName(MemoryTag tag);
+};
@@ -3,6 +3,9 @@
 #include "ModuleAudio.h"
 
 #include "raylib.h"
+#include <math.h>
+
+ModuleAudio* ModuleAudio::mixer = NULL;
 
 static float Clamp01(float v)
 {
@@ -14,16 +17,10 @@ static float Clamp01(float v)
 ModuleAudio::ModuleAudio(Application* app, bool start_enabled) : Module(app, start_enabled)
 {
 	fx_count = 0;
-	music = Music{ 0 };
 	sfxVolume = 1.0f;
 	musicVolume = 1.0f;
 	musicEnabled = true;
-
-	// Initialize FX array to a known state
-	for (unsigned int i = 0; i < MAX_SOUNDS; ++i)
-	{
-		fx[i] = Sound{ 0 };
-	}
+	listener = Vector2{ 0.0f, 0.0f };
 }
 
 ModuleAudio::~ModuleAudio()
@@ -34,70 +31,72 @@ bool ModuleAudio::Init()
 {
 	LOG("Loading Audio Mixer");
 	InitAudioDevice();
-	return true;
-}
 
-update_status ModuleAudio::Update()
-{
-	if (IsMusicReady(music))
+	// Packed with --pack-audio, loose files are used for anything not in it
+	if (FileExists(AUDIO_BANK_FILE))
+		bank.Open(AUDIO_BANK_FILE);
+
+	if (IsAudioDeviceReady())
 	{
-		UpdateMusicStream(music);
+		// Effects are only driven through the command queue from here on,
+		// the game thread never takes the mixer lock for them
+		mixer = this;
+		SetAudioPreMixCallback(OnPreMix);
+
+		engines.Init();
+		music.Init(&bank);
 	}
-	return UPDATE_CONTINUE;
+
+	return true;
 }
 
 bool ModuleAudio::CleanUp()
 {
 	LOG("Freeing sound FX, closing Audio subsystem");
 
+	// Pending commands reference the sounds about to be unloaded
+	if (mixer == this)
+	{
+		SetAudioPreMixCallback(NULL);
+		mixer = NULL;
+	}
+
 	for (unsigned int i = 0; i < fx_count; ++i)
 	{
-		UnloadSound(fx[i]);
+		// Aliases share the samples of the source, they go first
+		for (int v = 0; v < fx[i].voice_count; ++v)
+			UnloadSoundAlias(fx[i].voices[v].alias);
+
+		UnloadSound(fx[i].source);
+		fx[i] = FxPool();
 	}
+	fx_count = 0;
+	fx_bytes = 0;
 
-	StopMusic();
+	music.CleanUp();
+	engines.CleanUp();
+	bank.Close();
 
 	CloseAudioDevice();
 	return true;
 }
 
+// Loading and decoding happen on the music worker, the current track keeps
+// playing until the new one is ready and then crossfades over fade_time
 bool ModuleAudio::PlayMusic(const char* path, float fade_time, bool loop)
 {
-	(void)fade_time;
-
 	if (!IsEnabled() || !musicEnabled)
 		return false;
 
-	StopMusic();
-
-	music = LoadMusicStream(path);
-	music.looping = loop;
-
-	if (!IsMusicReady(music))
-	{
-		LOG("Cannot load music: %s", path);
-		music = Music{ 0 };
-		return false;
-	}
-
-	::SetMusicVolume(music, musicVolume);
-	PlayMusicStream(music);
-
-	LOG("Successfully playing %s", path);
-	return true;
+	return music.Play(path, fade_time, loop);
 }
 
-void ModuleAudio::StopMusic()
+void ModuleAudio::StopMusic(float fade_time)
 {
-	if (IsMusicReady(music))
-	{
-		StopMusicStream(music);
-		UnloadMusicStream(music);
-		music = Music{ 0 };
-	}
+	music.Stop(fade_time);
 }
 
-unsigned int ModuleAudio::LoadFx(const char* path)
+unsigned int ModuleAudio::LoadFx(const char* path, int voices)
 {
 	if (!IsEnabled())
 		return 0;
@@ -108,7 +107,20 @@ unsigned int ModuleAudio::LoadFx(const char* path)
 		return 0;
 	}
 
-	Sound sound = LoadSound(path);
+	Sound sound = Sound{ 0 };
+
+	// Effects stay fully decoded, voices start with no latency and overlap
+	// through aliases of one buffer. Only music streams from the bank
+	if (bank.Contains(path))
+	{
+		Wave wave = bank.LoadWave(path);
+		sound = LoadSoundFromWave(wave);
+		UnloadWave(wave);
+	}
+	else
+	{
+		sound = LoadSound(path);
+	}
 
 	if (sound.stream.buffer == NULL)
 	{
@@ -116,8 +128,34 @@ unsigned int ModuleAudio::LoadFx(const char* path)
 		return 0;
 	}
 
-	fx[fx_count] = sound;
-	SetSoundVolume(fx[fx_count], sfxVolume);
+	FxPool& pool = fx[fx_count];
+	pool.source = sound;
+	pool.duration = (sound.stream.sampleRate > 0) ? (float)sound.frameCount / (float)sound.stream.sampleRate : 0.0f;
+	pool.voice_count = 0;
+
+	if (voices < 1) voices = 1;
+	if (voices > MAX_FX_VOICES) voices = MAX_FX_VOICES;
+
+	for (int v = 0; v < voices; ++v)
+	{
+		Sound alias = LoadSoundAlias(sound);
+		if (alias.stream.buffer == NULL)
+			break;
+
+		pool.voices[pool.voice_count++].alias = alias;
+	}
+
+	if (pool.voice_count == 0)
+	{
+		LOG("Cannot create voices for sound: %s", path);
+		UnloadSound(sound);
+		pool = FxPool();
+		return 0;
+	}
+
+	uint64 bytes = (uint64)sound.frameCount * sound.stream.channels * (sound.stream.sampleSize / 8);
+	fx_bytes += bytes;
+	LOG("Loaded sound %s: %.1f KB decoded, %.1f KB for all effects", path, bytes / 1024.0, fx_bytes / 1024.0);
 
 	return fx_count++;
 }
@@ -130,35 +168,103 @@ bool ModuleAudio::PlayFx(unsigned int id, int repeat)
 		return false;
 
 	// Keeps original behavior: does not restart if already playing
-	if (!IsSoundPlaying(fx[id]))
+	return PlayVoice(fx[id], FX_NO_EMITTER, FX_PRIORITY_NORMAL, 1.0f);
+}
+
+bool ModuleAudio::PlayFx(unsigned int id, Vector2 position, int emitter, int priority)
+{
+	if (!IsEnabled() || id >= fx_count)
+		return false;
+
+	float dx = position.x - listener.x;
+	float dy = position.y - listener.y;
+	float distance_sq = dx * dx + dy * dy;
+
+	if (distance_sq >= FX_MAX_DISTANCE * FX_MAX_DISTANCE)
+		return false;
+
+	float volume = 1.0f - sqrtf(distance_sq) / FX_MAX_DISTANCE;
+
+	return PlayVoice(fx[id], emitter, priority, volume);
+}
+
+void ModuleAudio::StopFx(unsigned int id)
+{
+	if (id >= fx_count)
+		return;
+
+	FxPool& pool = fx[id];
+	for (int v = 0; v < pool.voice_count; ++v)
 	{
-		SetSoundVolume(fx[id], sfxVolume);
-		PlaySound(fx[id]);
+		if (pool.voices[v].end_time > 0.0)
+		{
+			PostCommand(AUDIO_COMMAND_STOP, pool.voices[v].alias);
+			pool.voices[v].end_time = 0.0;
+		}
 	}
+}
 
-	return true;
+void ModuleAudio::SetListener(Vector2 position)
+{
+	listener = position;
 }
 
-void ModuleAudio::StopFx(unsigned int id)
+void ModuleAudio::SetEngine(int car, float rpm, float throttle, Vector2 position)
+{
+	if (!IsEnabled() || car < 0 || car >= ENGINE_MAX_CARS)
+		return;
+
+	float dx = position.x - listener.x;
+	float dy = position.y - listener.y;
+	float distance_sq = dx * dx + dy * dy;
+
+	EngineParams params;
+	params.car = car;
+	params.rpm = rpm;
+	params.throttle = Clamp01(throttle);
+
+	if (distance_sq < FX_MAX_DISTANCE * FX_MAX_DISTANCE)
+	{
+		params.gain = (1.0f - sqrtf(distance_sq) / FX_MAX_DISTANCE) * sfxVolume;
+		params.pan = dx / (FX_MAX_DISTANCE * 0.5f);
+		if (params.pan < -1.0f) params.pan = -1.0f;
+		if (params.pan > 1.0f) params.pan = 1.0f;
+	}
+
+	// Engines out of hearing are posted once with no gain, then left alone so
+	// a stress race only queues the audible ones
+	bool audible = params.gain > 0.0f;
+	if (!audible && !engine_audible[car])
+		return;
+
+	if (engines.Post(params))
+		engine_audible[car] = audible;
+}
+
+void ModuleAudio::StopEngines()
 {
-	if (id < fx_count)
-		StopSound(fx[id]);
+	engines.SilenceAll();
+
+	for (int i = 0; i < ENGINE_MAX_CARS; ++i)
+		engine_audible[i] = false;
 }
 
 void ModuleAudio::SetSfxVolume(float volume)
 {
-	sfxVolume = Clamp01(volume);
+	volume = Clamp01(volume);
+
+	// The options slider sets it every frame
+	if (volume == sfxVolume)
+		return;
+
+	sfxVolume = volume;
 	ApplySfxVolume();
 }
 
 void ModuleAudio::SetMusicVolume(float volume)
 {
 	musicVolume = Clamp01(volume);
-
-	if (IsMusicReady(music))
-	{
-		::SetMusicVolume(music, musicVolume);
-	}
+	music.SetVolume(musicVolume);
 }
 
 float ModuleAudio::GetSfxVolume() const
@@ -177,7 +283,7 @@ void ModuleAudio::SetMusicEnabled(bool enabled)
 
 	if (!musicEnabled)
 	{
-		StopMusic();
+		StopMusic(0.0f);
 	}
 }
 
@@ -186,10 +292,116 @@ bool ModuleAudio::IsMusicEnabled() const
 	return musicEnabled;
 }
 
+// Only voices still sounding are updated, the rest get their volume when played
 void ModuleAudio::ApplySfxVolume()
 {
+	double now = GetTime();
+
 	for (unsigned int i = 0; i < fx_count; ++i)
 	{
-		SetSoundVolume(fx[i], sfxVolume);
+		FxPool& pool = fx[i];
+		for (int v = 0; v < pool.voice_count; ++v)
+		{
+			FxVoice& voice = pool.voices[v];
+			if (now >= voice.end_time)
+				continue;
+
+			float gain = voice.volume * sfxVolume;
+			if (PostCommand(AUDIO_COMMAND_VOLUME, voice.alias, gain))
+				voice.applied = gain;
+		}
+	}
+}
+
+// Voice counts are a handful per effect, the scan is constant time
+bool ModuleAudio::PlayVoice(FxPool& pool, int emitter, int priority, float volume)
+{
+	double now = GetTime();
+	FxVoice* free_voice = NULL;
+	FxVoice* victim = NULL;
+
+	for (int v = 0; v < pool.voice_count; ++v)
+	{
+		FxVoice& voice = pool.voices[v];
+
+		if (now >= voice.end_time)
+		{
+			if (free_voice == NULL) free_voice = &voice;
+			continue;
+		}
+
+		if (voice.emitter == emitter)
+			return true;
+
+		if (victim == NULL || voice.priority < victim->priority ||
+			(voice.priority == victim->priority && (voice.volume < victim->volume ||
+			(voice.volume == victim->volume && voice.start_time < victim->start_time))))
+		{
+			victim = &voice;
+		}
+	}
+
+	if (free_voice == NULL)
+	{
+		if (victim == NULL || victim->priority > priority)
+			return false;
+
+		// Play restarts the alias from its first frame, no stop needed
+		free_voice = victim;
+	}
+
+	float gain = volume * sfxVolume;
+	if (free_voice->applied != gain)
+	{
+		if (!PostCommand(AUDIO_COMMAND_VOLUME, free_voice->alias, gain))
+			return false;
+
+		free_voice->applied = gain;
+	}
+
+	if (!PostCommand(AUDIO_COMMAND_PLAY, free_voice->alias))
+		return false;
+
+	free_voice->emitter = emitter;
+	free_voice->priority = priority;
+	free_voice->volume = volume;
+	free_voice->start_time = now;
+	free_voice->end_time = now + pool.duration;
+
+	return true;
+}
+
+// A full queue means the mixer stalled, the change is dropped rather than waiting on it
+bool ModuleAudio::PostCommand(AudioCommandType type, const Sound& sound, float volume)
+{
+	if (mixer != this)
+		return false;
+
+	AudioCommand command;
+	command.type = type;
+	command.sound = sound;
+	command.volume = volume;
+
+	return commands.Push(command);
+}
+
+// Audio thread, raudio holds its lock while this runs
+void ModuleAudio::OnPreMix(void* buffer, unsigned int frames)
+{
+	(void)buffer;
+	(void)frames;
+
+	if (mixer == NULL)
+		return;
+
+	AudioCommand command;
+	while (mixer->commands.Pop(command))
+	{
+		switch (command.type)
+		{
+		case AUDIO_COMMAND_PLAY: PlaySoundInLockedState(command.sound); break;
+		case AUDIO_COMMAND_STOP: StopSoundInLockedState(command.sound); break;
+		case AUDIO_COMMAND_VOLUME: SetSoundVolumeInLockedState(command.sound, command.volume); break;
+		}
 	}
 }
@@ -1,11 +1,64 @@
 #pragma once
 
 #include "Module.h"
+#include "AudioBank.h"
+#include "EngineAudio.h"
+#include "MusicPlayer.h"
+#include "SpscQueue.h"
 #include "raylib.h"
 
 #define MAX_SOUNDS 16
+#define MAX_FX_VOICES 8			// aliases of one effect that can sound at once
+#define DEFAULT_FX_VOICES 4
+#define FX_MAX_DISTANCE 1200.0f		// pixels from the listener, farther plays are dropped
+#define FX_NO_EMITTER -1
+#define AUDIO_COMMAND_QUEUE_SIZE 256
 #define DEFAULT_MUSIC_FADE_TIME 2.0f
 
+enum FxPriority
+{
+	FX_PRIORITY_LOW = 0,
+	FX_PRIORITY_NORMAL,
+	FX_PRIORITY_HIGH
+};
+
+enum AudioCommandType
+{
+	AUDIO_COMMAND_PLAY,
+	AUDIO_COMMAND_STOP,
+	AUDIO_COMMAND_VOLUME
+};
+
+// Sound change posted by the game thread, applied by the mixer before its next mix
+struct AudioCommand
+{
+	AudioCommandType type = AUDIO_COMMAND_PLAY;
+	Sound sound = { 0 };
+	float volume = 1.0f;
+};
+
+// One alias of a loaded effect. The end time comes from the sound length so
+// finding a free voice never has to ask the mixer
+struct FxVoice
+{
+	Sound alias = { 0 };
+	int emitter = FX_NO_EMITTER;
+	int priority = FX_PRIORITY_LOW;
+	float volume = 0.0f;		// gain asked for, before the sfx volume
+	float applied = -1.0f;		// last volume posted to the mixer
+	double start_time = 0.0;
+	double end_time = 0.0;
+};
+
+// Loaded effect: the sound owning the samples plus the aliases that play it
+struct FxPool
+{
+	Sound source = { 0 };
+	float duration = 0.0f;
+	int voice_count = 0;
+	FxVoice voices[MAX_FX_VOICES];
+};
+
 class ModuleAudio : public Module
 {
 public:
@@ -13,17 +66,24 @@ public:
 	~ModuleAudio();
 
 	bool Init();
-	update_status Update();
 	bool CleanUp();
 
 	// Music
 	bool PlayMusic(const char* path, float fade_time = DEFAULT_MUSIC_FADE_TIME, bool loop = true);
-	void StopMusic();
+	void StopMusic(float fade_time = DEFAULT_MUSIC_FADE_TIME);
 
 	// FX
-	unsigned int LoadFx(const char* path);
+	unsigned int LoadFx(const char* path, int voices = DEFAULT_FX_VOICES);
 	bool PlayFx(unsigned int fx, int repeat = 0);
+	// Positional play. An emitter already sounding this effect is not restarted,
+	// when every voice is busy the lowest priority, quietest, oldest one is stolen
+	bool PlayFx(unsigned int fx, Vector2 position, int emitter, int priority = FX_PRIORITY_NORMAL);
 	void StopFx(unsigned int id);
+	void SetListener(Vector2 position);
+
+	// Engine synth, call every frame for each car that should be heard
+	void SetEngine(int car, float rpm, float throttle, Vector2 position);
+	void StopEngines();
 
 	// Audio settings
 	void SetSfxVolume(float volume);    // 0.0f - 1.0f
@@ -36,10 +96,21 @@ public:
 
 private:
 	void ApplySfxVolume();
+	bool PlayVoice(FxPool& pool, int emitter, int priority, float volume);
+	bool PostCommand(AudioCommandType type, const Sound& sound, float volume = 1.0f);
+
+	static void OnPreMix(void* buffer, unsigned int frames);
+	static ModuleAudio* mixer;
 
-	Music music;
-	Sound fx[MAX_SOUNDS];
+	AudioBank bank;
+	MusicPlayer music;
+	FxPool fx[MAX_SOUNDS];
 	unsigned int fx_count;
+	uint64 fx_bytes = 0;		// device format PCM held by every loaded effect
+	Vector2 listener;
+	EngineAudio engines;
+	bool engine_audible[ENGINE_MAX_CARS] = { false };	// the last update posted for the car had gain
+	SpscQueue<AudioCommand, AUDIO_COMMAND_QUEUE_SIZE> commands;
 
 	float sfxVolume;
 	float musicVolume;
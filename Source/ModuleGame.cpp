@@ -5,10 +5,17 @@
 #include "ModuleAudio.h"
 #include "ModulePhysics.h"
 #include "ModuleState.h"
+#include "ModuleUI.h"
+#include "StateTrace.h"
+#include "Benchmark.h"
 #include <algorithm>
 #include <string>
 #include <fstream>
 #include <sstream>
+#include <time.h>
+
+// Every car of the largest --stress race keeps its own engine voice
+static_assert(RACE_CAR_COUNT + STRESS_MAX_CARS <= ENGINE_MAX_CARS, "ENGINE_MAX_CARS must cover a full --stress race");
 
 struct Waypoint
 {
@@ -35,6 +42,11 @@ protected:
 public:
 	virtual ~PhysicEntity() = default;
 	virtual void Update() = 0;
+
+	// Once per physics tick, before the world steps
+	virtual void FixedUpdate()
+	{
+	}
 	
 	virtual int RayHit(vec2<int> ray, vec2<int> mouse, vec2<float>& normal)
 	{
@@ -51,9 +63,9 @@ class Tire : public PhysicEntity
 public:
 	ModuleRender* renderer;
 
-	Tire(ModuleRender* render,ModulePhysics* physics, int _x, int _y, int _w, int _h, int dir, Module* _listener, Texture2D _texture)
+	Tire(ModuleRender* render,ModulePhysics* physics, int _x, int _y, int _w, int _h, int dir, Module* _listener, int _sprite)
 		: PhysicEntity(physics->CreateTire(_x, _y, _w, _h, dir), _listener)
-		, texture(_texture), physicsM(physics)
+		, sprite(_sprite), physicsM(physics)
 	{
 		renderer = render;
 	}
@@ -71,7 +83,7 @@ public:
 	int direction = 0;
 	Vector2 speed = { 0,0 };
 
-	void Update() override
+	void FixedUpdate() override
 	{
 		if (body == nullptr) {
 			LOG("TIRE ERROR: body == NULL");
@@ -87,31 +99,45 @@ public:
 		physicsM->UpdateTireFriction(maxLateralImpulse, body->body);
 		physicsM->UpdateTire(maxForwardSpeed, maxBackwardSpeed, speed, maxDriveForce, body->body);
 		physicsM->UpdateTireTurn(direction, maxSteeringAngle, steeringAngle, body->body);
+	}
+
+	void Update() override
+	{
+		if (body == nullptr || body->body == nullptr)
+			return;
 
 		int x, y;
 		body->GetPhysicPosition(x, y);
 		float rotation = body->GetRotation() * RAD2DEG;
-		Rectangle src = { 0, 0, texture.width, texture.height };
-		Rectangle dest = {
-			(float)x,
-			(float)y,
-			(float)body->width * 2,
-			(float)body->height * 2
-		};
-		Vector2 origin = {
-			(float)body->width,
-			(float)body->height
-		};
-		
-		renderer->Draw(texture, x, y, &src, rotation, body->width, body->height, 0.2f);
-		//DrawTexturePro(texture, src, dest, origin, rotation, WHITE);
+
+		renderer->DrawSprite(sprite, x, y, rotation, body->width, body->height, 0.2f);
 	}
 
 private:
-	Texture2D texture;
+	int sprite;
 	ModulePhysics* physicsM;
 };
 
+// Fraction of the segment from-to where it enters the circle, 1 when it starts outside and never does
+static float CrossingFraction(b2Vec2 from, b2Vec2 to, b2Vec2 center, float radius)
+{
+	b2Vec2 d = to - from;
+	b2Vec2 f = from - center;
+
+	float a = b2Dot(d, d);
+	float b = 2.0f * b2Dot(f, d);
+	float c = b2Dot(f, f) - radius * radius;
+
+	if (c <= 0.0f) return 0.0f;
+	if (a <= 0.0f) return 1.0f;
+
+	float discriminant = b * b - 4.0f * a * c;
+	if (discriminant < 0.0f) return 1.0f;
+
+	float t = (-b - sqrtf(discriminant)) / (2.0f * a);
+	return (t < 0.0f) ? 0.0f : (t > 1.0f) ? 1.0f : t;
+}
+
 class Car : public PhysicEntity
 {
 public:
@@ -128,10 +154,17 @@ public:
 	int currentLap = 0;
 	float waypointRadius = 100.0f;
 
-	Timer raceTimer;                 
-	Timer lapTimer;                  
+	// Race clock ticks with the sub-tick crossing fraction, lapTimes in seconds
+	double lapStartTick = 0.0;
+	double finishTick = 0.0;
 	std::vector<double> lapTimes;
 
+	// Seconds into the lap at each waypoint of the current lap and of the best one
+	std::vector<double> splitTimes;
+	std::vector<double> bestSplits;
+	RaceSplit lastSplit;
+	b2Vec2 lastPosition = { 0.0f, 0.0f };
+
 	bool raceFinished = false;
 
 	int id;
@@ -141,16 +174,17 @@ public:
 
 	Car(ModuleRender* render, ModulePhysics* physics, int x, int y, int w, int h, int dir,
 		Tire* fl, Tire* fr, Tire* rl, Tire* rr,
-		Module* listener, Texture2D tex, bool isPlayer, int _id)
+		Module* listener, int _sprite, bool isPlayer, int _id)
 		: PhysicEntity(physics->CreateCar(x, y, w, h, dir,
 			fl->body->body, fr->body->body, rl->body->body, rr->body->body), listener)
-		, texture(tex)
+		, sprite(_sprite)
 		, frontLeft(fl), frontRight(fr), rearLeft(rl), rearRight(rr)
 	{
 		isplayer = isPlayer;
 		renderer = render;
 		id = _id;
 		phys = physics;
+		lastPosition = body->body->GetPosition();
 	}
 
 	~Car() override
@@ -175,6 +209,14 @@ public:
 		}
 	}
 
+	void FixedUpdate() override
+	{
+		frontLeft->FixedUpdate();
+		frontRight->FixedUpdate();
+		rearLeft->FixedUpdate();
+		rearRight->FixedUpdate();
+	}
+
 	void Update() override
 	{
 		if (body == nullptr) LOG("CAR ERROR: body == NULL");
@@ -190,21 +232,8 @@ public:
 		int x, y;
 		body->GetPhysicPosition(x, y);
 		float rotation = body->GetRotation() * RAD2DEG;
-		Rectangle src = { 0, 0, (float)texture.width, (float)texture.height };
-		Rectangle dest = {
-			(float)x,
-			(float)y,
-			(float)body->width * 2,
-			(float)body->height * 2
-		};
-		Vector2 origin = {
-			(float)body->width - 15,
-			(float)body->height
-		};
-		
-		renderer->Draw(texture, x, y, &src, rotation, origin.x, origin.y, 0.2f);
-		//DrawTexturePro(texture, src, dest, origin, rotation, WHITE);
 
+		renderer->DrawSprite(sprite, x, y, rotation, body->width - 15, body->height, 0.2f);
 	}
 
 	void GoToWaypoint(const Waypoint& wp)
@@ -271,33 +300,181 @@ public:
 		}
 		Waypoint& wp = waypoints[currentWaypoint];
 
+		b2Vec2 position = body->body->GetPosition();
+		b2Vec2 from = lastPosition;
+		lastPosition = position;
+
 		if (HasReachedWaypoint(wp))
 		{
+			// The position is sampled at the start of the tick, the waypoint was
+			// reached somewhere between the previous sample and this one
+			float radius = PIXEL_TO_METERS(waypointRadius);
+			b2Vec2 center(PIXEL_TO_METERS(wp.x), PIXEL_TO_METERS(wp.y));
+			double crossTick = (double)phys->App->scene_intro->race_tick - 2.0 + CrossingFraction(from, position, center, radius);
+
+			// A car spawned inside a waypoint reaches it at the start of the lap, not before
+			if (crossTick < lapStartTick)
+				crossTick = lapStartTick;
+
+			lastSplit.checkpoint = currentWaypoint;
+			lastSplit.time = ModulePhysics::TicksToSeconds(crossTick - lapStartTick);
+			lastSplit.has_delta = splitTimes.size() < bestSplits.size();
+			lastSplit.delta = lastSplit.has_delta ? lastSplit.time - bestSplits[splitTimes.size()] : 0.0;
+			lastSplit.tick = crossTick;
+			splitTimes.push_back(lastSplit.time);
+
 			currentWaypoint++;
 
-			waypointOffset.x = GetRandomValue(-maxOffset, maxOffset);
-			waypointOffset.y = GetRandomValue(-maxOffset, maxOffset);
+			waypointOffset.x = phys->App->scene_intro->random.GetValue(-maxOffset, maxOffset);
+			waypointOffset.y = phys->App->scene_intro->random.GetValue(-maxOffset, maxOffset);
 
 			if (currentWaypoint >= waypoints.size()) {
 				currentWaypoint = 0;
 				currentLap++;
+
+				// The last split is the lap time, both vectors keep their capacity
+				lapTimes.push_back(lastSplit.time);
+				lapStartTick = crossTick;
+
+				if (bestSplits.empty() || lastSplit.time < bestSplits.back())
+					bestSplits = splitTimes;
+				splitTimes.clear();
+
 				if (id == 0) {
-					phys->App->audio->PlayFx(phys->App->scene_intro->lap_fx);
-					double lapTime = lapTimer.ReadSec();
-					lapTimes.push_back(lapTime);
-					lapTimer.Start();
-					if (currentLap == 3) {
+					int x, y;
+					body->GetPhysicPosition(x, y);
+					phys->App->audio->PlayFx(phys->App->scene_intro->lap_fx, Vector2{ (float)x, (float)y }, id, FX_PRIORITY_HIGH);
+					if (currentLap == RACE_LAP_COUNT) {
 						raceFinished = true;
+						finishTick = crossTick;
 					}
 				}
 			}
 		}
 	}
 private:
-	Texture2D texture;
+	int sprite;
 
 };
 
+// Loose dynamic body for the stress mode, drawn with its sprite stretched over the shape
+class Debris : public PhysicEntity
+{
+public:
+	Debris(ModuleRender* render, ModulePhysics* physics, PhysBody* _body, Module* _listener, int _sprite)
+		: PhysicEntity(_body, _listener)
+		, renderer(render), phys(physics), sprite(_sprite)
+	{
+		// Settles after being hit instead of sliding across the map
+		body->body->SetLinearDamping(2.0f);
+		body->body->SetAngularDamping(2.0f);
+	}
+
+	~Debris() override
+	{
+		phys->DeleteBody(body);
+		body = nullptr;
+	}
+
+	void Update() override
+	{
+		int x, y;
+		body->GetPhysicPosition(x, y);
+
+		Rectangle section = renderer->GetSpriteSection(sprite);
+		float scale = (section.width > 0.0f) ? (body->width * 2.0f) / section.width : 1.0f;
+
+		renderer->DrawSprite(sprite, x, y, body->GetRotation() * RAD2DEG, body->width, body->height, scale);
+	}
+
+private:
+	ModuleRender* renderer;
+	ModulePhysics* phys;
+	int sprite;
+};
+
+static uint32 ReadInput()
+{
+	uint32 buttons = 0;
+
+	if (IsKeyDown(KEY_W)) buttons |= INPUT_THROTTLE;
+	if (IsKeyDown(KEY_S)) buttons |= INPUT_BRAKE;
+	if (IsKeyDown(KEY_SPACE)) buttons |= INPUT_BOOST;
+	if (IsKeyDown(KEY_A)) buttons |= INPUT_LEFT;
+	if (IsKeyDown(KEY_D)) buttons |= INPUT_RIGHT;
+
+	return buttons;
+}
+
+// State at the start of the tick, forces for it already applied
+static TelemetrySample SampleTelemetry(Car* car)
+{
+	b2Body* body = car->body->body;
+	b2Vec2 velocity = body->GetLinearVelocity();
+
+	TelemetrySample sample;
+	sample.x = body->GetPosition().x;
+	sample.y = body->GetPosition().y;
+	sample.heading = body->GetAngle();
+	sample.speed = b2Dot(velocity, body->GetWorldVector(b2Vec2(0, -1)));
+	sample.slip = b2Dot(velocity, body->GetWorldVector(b2Vec2(1, 0)));
+	sample.steer = car->frontLeft->body->body->GetAngle() - body->GetAngle();
+	sample.waypoint = car->currentWaypoint;
+	sample.lap = car->currentLap;
+
+	return sample;
+}
+
+static ReplayTransform SampleReplay(Car* car)
+{
+	int x, y;
+	car->body->GetPhysicPosition(x, y);
+
+	ReplayTransform transform;
+	transform.x = (float)x;
+	transform.y = (float)y;
+	transform.angle = car->body->GetRotation();
+	transform.steer = car->frontLeft->body->GetRotation() - transform.angle;
+
+	return transform;
+}
+
+static void ApplyInput(Car* car, uint32 buttons)
+{
+	if (buttons & INPUT_THROTTLE) {
+		car->frontLeft->speed.y = car->frontLeft->maxForwardSpeed;
+		car->frontRight->speed.y = car->frontRight->maxForwardSpeed;
+	}
+	else if (buttons & INPUT_BRAKE) {
+		car->frontLeft->speed.y = -car->frontLeft->maxBackwardSpeed;
+		car->frontRight->speed.y = -car->frontRight->maxBackwardSpeed;
+	}
+	else {
+		car->frontLeft->speed.y = 0;
+		car->frontRight->speed.y = 0;
+	}
+	if (buttons & INPUT_BOOST) {
+		car->frontLeft->maxDriveForce = 1.0f;
+		car->frontRight->maxDriveForce = 1.0f;
+	}
+	else {
+		car->frontLeft->maxDriveForce = 1.0f * 0.5f;
+		car->frontRight->maxDriveForce = 1.0f * 0.5f;
+	}
+	if (buttons & INPUT_LEFT) {
+		car->frontLeft->direction = 1;
+		car->frontRight->direction = 1;
+	}
+	else if (buttons & INPUT_RIGHT) {
+		car->frontLeft->direction = -1;
+		car->frontRight->direction = -1;
+	}
+	else {
+		car->frontLeft->direction = 0;
+		car->frontRight->direction = 0;
+	}
+}
+
 ModuleGame::ModuleGame(Application* app, bool start_enabled) : Module(app, start_enabled)
 {
 	ray_on = false;
@@ -316,18 +493,47 @@ bool ModuleGame::Start()
 
 	
 
-	circle = LoadTexture("Assets/wheel.png");
-	box = LoadTexture("Assets/crate.png");
-	rick = LoadTexture("Assets/rick_head.png");
+	// Small sprites are packed into the renderer atlas, the map is too big and stays alone
+	circle = App->renderer->LoadSprite("Assets/wheel.png");
+	box = App->renderer->LoadSprite("Assets/crate.png");
+	rick = App->renderer->LoadSprite("Assets/rick_head.png");
 	map = LoadTexture("Assets/Map1/Map.png");
-	wheel = LoadTexture("Assets/Rueda.png");
-	carT = LoadTexture("Assets/Car.png");
+	wheel = App->renderer->LoadSprite("Assets/Rueda.png");
+	carT = App->renderer->LoadSprite("Assets/Car.png");
 
 	bonus_fx = App->audio->LoadFx("Assets/bonus.wav");
 	lap_fx = App->audio->LoadFx("Assets/Audio/SFX/f1.wav");
-	accelerate_fx = App->audio->LoadFx("Assets/Audio/SFX/car.wav");
 
-	App->state->ChangeState(GameState::MENU_MAIN);
+	// --bench <file> measures the hot paths and quits, the game never starts
+	if (!bench_file.empty())
+	{
+		RunBenchmarks(bench_file.c_str());
+		return ret;
+	}
+
+	if (!telemetry_file.empty())
+		telemetry.Open(telemetry_file.c_str());
+
+	// --perf <baseline> plays the recorded race of every map back to back,
+	// Assets/perf_baseline.txt is the committed baseline of those races. It only
+	// holds the hardware independent metrics, times missing from it are printed
+	// but not gated
+	if (!App->perf_baseline.empty())
+	{
+		if (!StartNextPerfRace())
+			LOG("No %s found in the map folders", PERF_RACE_FILE);
+	}
+	// --replay <file> starts straight into the recorded race
+	else if (!replay_file.empty() && input_log.Load(replay_file.c_str(), MAP_COUNT))
+	{
+		replaying = true;
+		App->state->mapId = input_log.GetMapId();
+		App->state->ChangeState(GameState::RACE);
+	}
+	else
+	{
+		App->state->ChangeState(GameState::MENU_MAIN);
+	}
 
 	return ret;
 }
@@ -337,6 +543,8 @@ bool ModuleGame::CleanUp()
 {
 	LOG("Unloading Intro scene");
 
+	telemetry.Close();
+
 	return true;
 }
 
@@ -349,13 +557,17 @@ void  ModuleGame::CreateCar(int x, int y, int w, int h, float scale, int dir, bo
 	Car* car = new Car(App->renderer,App->physics, x, y, w * scale, h * scale, dir, fl, fr, rl, rr, this, carT, playable, id);
 	entities.emplace_back(car);
 
-	if (car->isplayer)
-	{
-		car->raceTimer.Start();
-		car->lapTimer.Start();
-		car->lapTimes.clear();
-		car->raceFinished = false;
-	}
+	// Race clock starts with the next tick, see CreateRace()
+	car->lapStartTick = 0.0;
+	car->finishTick = 0.0;
+	car->lapTimes.clear();
+	car->lapTimes.reserve(RACE_LAP_COUNT * 2);		// AI cars keep lapping until the player finishes
+	car->splitTimes.clear();
+	car->splitTimes.reserve(waypoints.size());
+	car->bestSplits.clear();
+	car->bestSplits.reserve(waypoints.size());
+	car->lastSplit = RaceSplit();
+	car->raceFinished = false;
 }
 
 void ModuleGame::CreateRace(int x, int y, int w, int h, float scale, int dir) {
@@ -364,7 +576,7 @@ void ModuleGame::CreateRace(int x, int y, int w, int h, float scale, int dir) {
 	const float rowSpacing = METERS_TO_PIXELS(3);
 	const float colSpacing = METERS_TO_PIXELS(2);
 
-	for (int i = 0; i < 6; ++i)
+	for (int i = 0; i < RACE_CAR_COUNT; ++i)
 	{
 		int row = i / carsPerRow;
 		int col = i % carsPerRow;
@@ -405,6 +617,36 @@ void ModuleGame::CreateRace(int x, int y, int w, int h, float scale, int dir) {
 		);
 	}
 
+	// Same seed and tick zero for both recording and replay
+	uint32 seed = replaying ? input_log.GetSeed() : (uint32)time(NULL);
+	random.Seed(seed);
+	race_tick = 0;
+	player_input = 0;
+
+	if (stress.cars > 0)
+		SpawnCarsAlongTrack(MIN(MAX(stress.cars, STRESS_MIN_CARS), STRESS_MAX_CARS), RACE_CAR_COUNT);
+
+	SpawnDebris(stress.debris);
+
+	if (replaying) input_log.Rewind();
+	else input_log.Begin(seed, App->state->mapId);
+
+	telemetry.BeginRace(RACE_CAR_COUNT);
+
+	// Car and wheel sizes are the same for the whole grid
+	ReplayCar replay_car;
+	replay_car.body_w = (int)(w * scale);
+	replay_car.body_h = (int)(h * scale);
+	replay_car.tire_w = (int)(10 * scale) / 2;
+	replay_car.tire_h = (int)(20 * scale) / 2;
+
+	replay.Begin(std::vector<ReplayCar>(RACE_CAR_COUNT, replay_car));
+	replay_frame.assign(RACE_CAR_COUNT, ReplayTransform());
+
+	LoadGhosts(App->state->mapId);
+	ghost_lap.Begin(App->state->mapId, replay_car);
+	lap_start_tick = race_tick + 1;		// first tick FixedUpdate runs
+
 	onMenu = false;
 	onRace = true;
 }
@@ -412,6 +654,23 @@ void ModuleGame::CreateRace(int x, int y, int w, int h, float scale, int dir) {
 // Update: draw background
 update_status ModuleGame::Update()
 {
+	if (!bench_file.empty())
+		return UPDATE_STOP;
+
+	if (!App->perf_baseline.empty())
+	{
+		// A recorded race ends at the results screen or when its input runs out
+		if (onRace && input_log.IsFinished(race_tick))
+			App->state->ChangeState(GameState::RESULTS);
+
+		if (onResults || !App->perf.IsCapturing())
+		{
+			App->perf.EndRun();
+
+			if (!StartNextPerfRace())
+				return FinishPerfRaces();
+		}
+	}
 
 	if (IsKeyPressed(KEY_F1)) {
 
@@ -423,7 +682,17 @@ update_status ModuleGame::Update()
 			UpdateLeaderboard();
 		}
 
-		App->renderer->Draw(map,0,0,0,0,0,0,4);
+		App->renderer->Draw(map,0,0,0,0,0,0,4,LAYER_BACKGROUND);
+
+		if (viewing_replay) {
+			UpdateReplayViewer();
+			return UPDATE_CONTINUE;
+		}
+
+		if (onRace) {
+			DrawGhosts();
+		}
+
 		if (debug) {
 			DrawWaypointsDebug();
 			App->physics->DrawMouseJointDebug();
@@ -454,7 +723,11 @@ update_status ModuleGame::Update()
 		for (PhysicEntity* entity : entities)
 		{
 			Car* car = dynamic_cast<Car*>(entity);
-			if (!car) continue;
+			if (!car)
+			{
+				if (stress.render) entity->Update();
+				continue;
+			}
 
 			if (car->isplayer)
 			{
@@ -463,44 +736,12 @@ update_status ModuleGame::Update()
 				car->body->GetPhysicPosition(x, y);
 				App->renderer->camera.x = SCREEN_WIDTH / 2 - x; 
 				App->renderer->camera.y = SCREEN_HEIGHT / 2 - y;
+				App->audio->SetListener(Vector2{ (float)x, (float)y });
 
-				if (IsKeyDown(KEY_W)) {
-					car->frontLeft->speed.y = car->frontLeft->maxForwardSpeed;
-					car->frontRight->speed.y = car->frontRight->maxForwardSpeed;
-					App->audio->PlayFx(accelerate_fx);
-				}
-				else if (IsKeyDown(KEY_S)) {
-					car->frontLeft->speed.y = -car->frontLeft->maxBackwardSpeed;
-					car->frontRight->speed.y = -car->frontRight->maxBackwardSpeed;
-				}
-				else {
-					car->frontLeft->speed.y = 0;
-					car->frontRight->speed.y = 0;
-				}
-				if (IsKeyDown(KEY_SPACE)) {
-					car->frontLeft->maxDriveForce = 1.0f;
-					car->frontRight->maxDriveForce = 1.0f;
-				}
-				else {
-					car->frontLeft->maxDriveForce = 1.0f * 0.5f;
-					car->frontRight->maxDriveForce = 1.0f * 0.5f;
-				}
-				if (IsKeyDown(KEY_A)) {
-					car->frontLeft->direction = 1;
-					car->frontRight->direction = 1;
-				}
-				else if (IsKeyDown(KEY_D)) {
-					car->frontLeft->direction = -1;
-					car->frontRight->direction = -1;
-				}
-				else {
-					car->frontLeft->direction = 0;
-					car->frontRight->direction = 0;
-				}
 				if (car->raceFinished) {
 					results.finalLeaderboard = leaderboard;  
 					results.lapTimes = car->lapTimes;
-					results.totalTime = car->raceTimer.ReadSec();
+					results.totalTime = ModulePhysics::TicksToSeconds(car->finishTick);
 					App->state->ChangeState(GameState::RESULTS);
 				}
 			}
@@ -511,21 +752,222 @@ update_status ModuleGame::Update()
 					car->body->GetPhysicPosition(x, y);
 					App->renderer->camera.x = SCREEN_WIDTH / 2 - x;
 					App->renderer->camera.y = SCREEN_HEIGHT / 2 - y;
+					App->audio->SetListener(Vector2{ (float)x, (float)y });
 				}
-				car->GoToWaypoint(waypoints[car->currentWaypoint]);
 			}
 
-			
-			car->UpdateWaypointProgress();
+			if (stress.render)
+				car->Update();
 
-			
-			car->Update();
+			if (onRace && car->id >= 0 && stress.audio)
+			{
+				int x, y;
+				car->body->GetPhysicPosition(x, y);
+				float speed = car->body->body->GetLinearVelocity().Length();
+				float throttle = (!car->isplayer || (player_input & INPUT_THROTTLE)) ? 1.0f : 0.0f;
+				App->audio->SetEngine(car->id, EngineAudio::RpmFromSpeed(speed), throttle, Vector2{ (float)x, (float)y });
+			}
 		}
 	}
 
 	return UPDATE_CONTINUE;
 }
 
+// Called by ModulePhysics before every world step. Everything that moves the
+// simulation lives here so a race only depends on the tick count and the input log
+void ModuleGame::FixedUpdate()
+{
+	if (!onRace && !onMenu && !onResults)
+		return;
+
+	if (onRace)
+	{
+		if (replaying)
+		{
+			player_input = input_log.GetButtons(race_tick);
+		}
+		else
+		{
+			player_input = ReadInput();
+			input_log.Record(race_tick, player_input);
+		}
+
+		race_tick++;
+	}
+
+	for (PhysicEntity* entity : entities)
+	{
+		Car* car = dynamic_cast<Car*>(entity);
+		if (!car) continue;
+
+		if (car->isplayer)
+			ApplyInput(car, player_input);
+		else if (stress.ai)
+			car->GoToWaypoint(waypoints[car->currentWaypoint]);
+
+		int lap = car->currentLap;
+		car->UpdateWaypointProgress();
+
+		if (stress.physics)
+			car->FixedUpdate();
+
+		if (onRace && car->isplayer)
+			RecordGhostLap(SampleReplay(car), car->currentLap != lap);
+
+		if (onRace && car->id >= 0 && telemetry.IsOpen())
+			telemetry.Record(race_tick, car->id, SampleTelemetry(car));
+
+		if (onRace && car->id >= 0 && car->id < (int)replay_frame.size())
+			replay_frame[car->id] = SampleReplay(car);
+	}
+
+	if (onRace)
+	{
+		telemetry.EndTick();
+		replay.Record(race_tick, replay_frame.data());
+	}
+}
+
+void ModuleGame::LoadGhosts(int mapId)
+{
+	ghosts.clear();
+	best_ghost = -1;
+
+	std::string folder = "Assets/Map" + std::to_string(mapId);
+	if (!DirectoryExists(folder.c_str()))
+		return;
+
+	FilePathList files = LoadDirectoryFilesEx(folder.c_str(), GHOST_EXTENSION, false);
+
+	for (uint i = 0; i < files.count && ghosts.size() < GHOST_MAX_LOADED; ++i)
+	{
+		GhostTrack ghost;
+		if (!ghost.Load(files.paths[i]) || ghost.GetMapId() != mapId)
+			continue;
+
+		if (TextIsEqual(GetFileName(files.paths[i]), GHOST_BEST_FILE))
+			best_ghost = (int)ghosts.size();
+
+		ghosts.push_back(std::move(ghost));
+	}
+
+	UnloadDirectoryFiles(files);
+}
+
+// Called once per race tick with the player transform. A finished lap that
+// beats the stored best replaces Best.ghost and the ghost drawn for it
+void ModuleGame::RecordGhostLap(const ReplayTransform& transform, bool lap_completed)
+{
+	if (lap_completed)
+	{
+		uint32 lap_ticks = race_tick - lap_start_tick;
+		ghost_lap.End(lap_ticks);
+
+		bool best = best_ghost == -1 || lap_ticks < ghosts[best_ghost].GetLapTicks();
+		if (best && !replaying)
+		{
+			std::string path = "Assets/Map" + std::to_string(App->state->mapId) + "/" + GHOST_BEST_FILE;
+			ghost_lap.Save(path.c_str());
+
+			if (best_ghost == -1)
+			{
+				best_ghost = (int)ghosts.size();
+				ghosts.emplace_back();
+			}
+			ghosts[best_ghost] = ghost_lap;
+		}
+
+		ghost_lap.Begin(App->state->mapId, ghost_lap.GetCar());
+		lap_start_tick = race_tick;
+	}
+
+	ghost_lap.Record(race_tick - lap_start_tick, transform);
+}
+
+void ModuleGame::DrawGhosts()
+{
+	static const Color tint = { 255, 255, 255, GHOST_ALPHA };
+	float lap_tick = (float)(race_tick - lap_start_tick);
+
+	for (GhostTrack& ghost : ghosts)
+	{
+		ReplayTransform transform;
+		if (!ghost.Sample(lap_tick, transform))
+			continue;
+
+		const ReplayCar& car = ghost.GetCar();
+		App->renderer->DrawSprite(carT, (int)transform.x, (int)transform.y, transform.angle * RAD2DEG,
+			car.body_w - 15, car.body_h, 0.2f, LAYER_WORLD, tint);
+	}
+}
+
+void ModuleGame::StartReplayViewer()
+{
+	if (replay.IsEmpty())
+		return;
+
+	viewing_replay = true;
+	replay_paused = false;
+	replay_tick = 0.0f;
+}
+
+void ModuleGame::StopReplayViewer()
+{
+	viewing_replay = false;
+}
+
+// Left/Right scrub (Shift is faster), Space pauses. Runs on the frame clock,
+// every position is one keyframe decode away so seeking backwards costs the same
+void ModuleGame::UpdateReplayViewer()
+{
+	float step = GetFrameTime() * 60.0f;
+	float scrub = IsKeyDown(KEY_LEFT_SHIFT) ? 8.0f : 2.0f;
+
+	if (IsKeyPressed(KEY_SPACE)) replay_paused = !replay_paused;
+
+	if (IsKeyDown(KEY_RIGHT)) replay_tick += step * scrub;
+	else if (IsKeyDown(KEY_LEFT)) replay_tick -= step * scrub;
+	else if (!replay_paused) replay_tick += step;
+
+	float length = (float)replay.GetLength();
+	if (replay_tick < 0.0f) replay_tick = 0.0f;
+	if (replay_tick > length) replay_tick = length;
+
+	replay.Seek(replay_tick, replay_frame);
+
+	for (uint i = 0; i < replay.GetCarCount(); ++i)
+	{
+		const ReplayCar& car = replay.GetCar(i);
+		const ReplayTransform& transform = replay_frame[i];
+
+		float c = cosf(transform.angle);
+		float s = sinf(transform.angle);
+
+		// Wheels at the joint anchors of ModulePhysics::CreateCar, the front pair steers
+		const float anchors[4][2] = { { -0.30f, -0.80f }, { 0.30f, -0.80f }, { -0.30f, 0.05f }, { 0.30f, 0.05f } };
+		for (int t = 0; t < 4; ++t)
+		{
+			float ax = anchors[t][0] * car.body_w;
+			float ay = anchors[t][1] * car.body_h;
+			float angle = transform.angle + ((t < 2) ? transform.steer : 0.0f);
+
+			App->renderer->DrawSprite(wheel,
+				(int)(transform.x + ax * c - ay * s),
+				(int)(transform.y + ax * s + ay * c),
+				angle * RAD2DEG, car.tire_w, car.tire_h, 0.2f);
+		}
+
+		App->renderer->DrawSprite(carT, (int)transform.x, (int)transform.y, transform.angle * RAD2DEG, car.body_w - 15, car.body_h, 0.2f);
+	}
+
+	if (!replay_frame.empty())
+	{
+		App->renderer->camera.x = SCREEN_WIDTH / 2 - (int)replay_frame[0].x;
+		App->renderer->camera.y = SCREEN_HEIGHT / 2 - (int)replay_frame[0].y;
+		App->audio->SetListener(Vector2{ replay_frame[0].x, replay_frame[0].y });
+	}
+}
+
 void ModuleGame::OnCollision(PhysBody* bodyA, PhysBody* bodyB)
 {
 	for (PhysicEntity* entity : entities)
@@ -580,15 +1022,8 @@ void ModuleGame::DestroyMockUpCar() {
 
 void ModuleGame::UpdateLeaderboard()
 {
-	struct CarProgress
-	{
-		int id;
-		int waypoint;
-		int lap;
-		float distToNext;
-	};
-
-	std::vector<CarProgress> progress;
+	std::vector<CarProgress>& progress = leaderboard_progress;
+	progress.clear();
 
 	for (PhysicEntity* entity : entities)
 	{
@@ -653,7 +1088,7 @@ void ModuleGame::DrawWaypointsDebug()
 			WHITE
 		);*/
 
-		DrawRectanglePro(
+		App->renderer->DrawRectanglePro(
 			{
 				waypoints[i].x + App->renderer->camera.x,
 				waypoints[i].y + App->renderer->camera.y,
@@ -662,28 +1097,58 @@ void ModuleGame::DrawWaypointsDebug()
 			},
 			{ waypoints[i].w / 2.0f, waypoints[i].h / 2.0f },
 			waypoints[i].angle * RAD2DEG,
-			Fade(RED, 0.3f)
+			Fade(RED, 0.3f),
+			LAYER_DEBUG
 		);
 	}
 
 	
 	for (int i = 0; i < waypoints.size() - 1; ++i)
 	{
-		DrawLine(
+		App->renderer->DrawLine(
 			waypoints[i].x + App->renderer->camera.x,
 			waypoints[i].y + App->renderer->camera.y,
 			waypoints[i + 1].x + App->renderer->camera.x,
 			waypoints[i + 1].y + App->renderer->camera.y,
-			Fade(WHITE, 0.4f)
+			Fade(WHITE, 0.4f),
+			LAYER_DEBUG
 		);
 	}
 }
 
 void ModuleGame::DeleteRace() {
+	App->audio->StopEngines();
+	telemetry.EndRace();
+
+	if (onRace)
+	{
+		if (replaying)
+		{
+			replaying = false;
+		}
+		else if (race_tick > 0)
+		{
+			input_log.End(race_tick);
+			input_log.Save(INPUT_LOG_FILE);
+		}
+
+		// Stays in memory for the results screen
+		if (race_tick > 0)
+			replay.Save(REPLAY_FILE);
+	}
+
+	ghosts.clear();
+	best_ghost = -1;
+
 	for (auto it = entities.begin(); it != entities.end(); )
 	{
 		Car* car = dynamic_cast<Car*>(*it);
-		if (car && car->id >= 0)
+		if (!car)
+		{
+			delete *it;
+			it = entities.erase(it);
+		}
+		else if (car->id >= 0)
 		{
 			delete car;                 
 			it = entities.erase(it);   
@@ -744,7 +1209,10 @@ void ModuleGame::CreateMapBorders()
 
 void ModuleGame::CreateMap(int mapId)
 {
-	
+	// The menu and earlier races leave their trace in the broad-phase even
+	// after their bodies are gone, a fresh world keeps --replay bit-for-bit
+	App->physics->ResetWorld();
+
 	CreateMapBorders();
 
 	LoadWaypoints(mapId, true);
@@ -762,15 +1230,15 @@ void ModuleGame::CreateMap(int mapId)
 
 void ModuleGame::LoadWaypoints(int mapId, bool race)
 {
+	// The menu and results screens reload the sensors over the previous ones
+	for (Waypoint& wp : waypoints)
+	{
+		App->physics->DeleteBody(wp.sensor);
+	}
 	waypoints.clear();
 
 	// Valores por defecto (por seguridad)
-	int startX = 0;
-	int startY = 0;
-	int carW = 50;
-	int carH = 100;
-	float carScale = 1.0f;
-	int carDir = 0;
+	layout = MapLayout();
 
 	std::string mapName = "Assets/Map" + std::to_string(mapId) + "/Map.png";
 	UnloadTexture(map);
@@ -789,11 +1257,11 @@ void ModuleGame::LoadWaypoints(int mapId, bool race)
 	{
 		if (type == "START")
 		{
-			file >> startX >> startY;
+			file >> layout.start_x >> layout.start_y;
 		}
 		else if (type == "CAR")
 		{
-			file >> carW >> carH >> carScale >> carDir;
+			file >> layout.car_w >> layout.car_h >> layout.car_scale >> layout.car_dir;
 		}
 		else if (type == "WP")
 		{
@@ -813,13 +1281,17 @@ void ModuleGame::LoadWaypoints(int mapId, bool race)
 	file.close();
 
 	if (race) {
-		CreateRace(startX, startY, carW, carH, carScale, carDir);
+		CreateRace(layout.start_x, layout.start_y, layout.car_w, layout.car_h, layout.car_scale, layout.car_dir);
 	}
 }
 
 void ModuleGame::DeleteMap()
 {
 	// Borrar waypoints
+	for (Waypoint& wp : waypoints)
+	{
+		App->physics->DeleteBody(wp.sensor);
+	}
 	waypoints.clear();
 
 	// Borrar cuerpos fsicos del mapa (bordes)
@@ -832,13 +1304,323 @@ void ModuleGame::DeleteMap()
 	LOG("Map deleted");
 }
 
+void ModuleGame::SpawnCarsAlongTrack(int count, int first_id)
+{
+	int n = (int)waypoints.size();
+	if (n == 0 || count <= 0)
+		return;
+
+	// The waypoints close a loop, the last one leads back to the first
+	std::vector<float> lengths(n);
+	float total = 0.0f;
+	for (int i = 0; i < n; ++i)
+	{
+		const Waypoint& a = waypoints[i];
+		const Waypoint& b = waypoints[(i + 1) % n];
+		lengths[i] = sqrtf((float)((b.x - a.x) * (b.x - a.x) + (b.y - a.y) * (b.y - a.y)));
+		total += lengths[i];
+	}
+
+	const int lanes = 3;
+	const float laneSpacing = METERS_TO_PIXELS(2);
+
+	// Rows never closer than a car length plus a gap, so a long track is filled
+	// evenly and a short one runs out of rows instead of stacking cars
+	const float slot = layout.car_h * layout.car_scale + METERS_TO_PIXELS(1);
+
+	// Segment, heading and lane position of a point at some distance along the loop
+	auto locate = [&](float distance, int lane, int& segment, float& dx, float& dy, int& x, int& y)
+	{
+		segment = 0;
+		while (segment < n - 1 && distance > lengths[segment])
+		{
+			distance -= lengths[segment];
+			segment++;
+		}
+
+		const Waypoint& a = waypoints[segment];
+		const Waypoint& b = waypoints[(segment + 1) % n];
+		float length = lengths[segment];
+		dx = (length > 0.0f) ? (b.x - a.x) / length : 0.0f;
+		dy = (length > 0.0f) ? (b.y - a.y) / length : -1.0f;
+
+		float offset = (float)(lane - 1) * laneSpacing;
+		x = (int)(a.x + dx * distance - dy * offset);
+		y = (int)(a.y + dy * distance + dx * offset);
+	};
+
+	// The grid is already placed, rows reaching any of its cars are skipped
+	std::vector<Vector2> grid;
+	for (PhysicEntity* entity : entities)
+	{
+		Car* car = dynamic_cast<Car*>(entity);
+		if (!car) continue;
+
+		int x, y;
+		car->body->GetPhysicPosition(x, y);
+		grid.push_back(Vector2{ (float)x, (float)y });
+	}
+
+	std::vector<float> rows;
+	int max_rows = (int)(total / slot);
+
+	for (int k = 0; k < max_rows; ++k)
+	{
+		float distance = k * total / max_rows;
+		bool clear = true;
+
+		for (int lane = 0; lane < lanes && clear; ++lane)
+		{
+			int segment, x, y;
+			float dx, dy;
+			locate(distance, lane, segment, dx, dy, x, y);
+
+			for (const Vector2& car : grid)
+			{
+				float ox = car.x - x;
+				float oy = car.y - y;
+				if (ox * ox + oy * oy < slot * slot)
+				{
+					clear = false;
+					break;
+				}
+			}
+		}
+
+		if (clear)
+			rows.push_back(distance);
+	}
+
+	int capacity = (int)rows.size() * lanes;
+	if (count > capacity)
+	{
+		LOG("Stress: the track fits %d AI cars, %d asked", capacity, count);
+		count = capacity;
+	}
+	if (count <= 0)
+		return;
+
+	// Spread the rows used over all the free ones
+	int used_rows = (count + lanes - 1) / lanes;
+
+	for (int i = 0; i < count; ++i)
+	{
+		float distance = rows[(i / lanes) * rows.size() / used_rows];
+
+		int segment, x, y;
+		float dx, dy;
+		locate(distance, i % lanes, segment, dx, dy, x, y);
+
+		// CreateCar() only takes the four grid directions (0 up, 1 right, 2 down, 3 left)
+		int dir = (fabsf(dx) > fabsf(dy)) ? ((dx > 0.0f) ? 1 : 3) : ((dy < 0.0f) ? 0 : 2);
+
+		CreateCar(x, y, layout.car_w, layout.car_h, layout.car_scale, dir, false, first_id + i);
+
+		Car* car = dynamic_cast<Car*>(entities.back());
+		car->currentWaypoint = (segment + 1) % n;
+	}
+}
+
+void ModuleGame::SpawnDebris(int count)
+{
+	int n = (int)waypoints.size();
+	if (n == 0)
+		return;
+
+	const int spread = METERS_TO_PIXELS(3);
+
+	for (int i = 0; i < count; ++i)
+	{
+		int segment = random.GetValue(0, n - 1);
+		const Waypoint& a = waypoints[segment];
+		const Waypoint& b = waypoints[(segment + 1) % n];
+
+		float t = random.GetValue(0, 100) / 100.0f;
+		int x = (int)(a.x + (b.x - a.x) * t) + random.GetValue(-spread, spread);
+		int y = (int)(a.y + (b.y - a.y) * t) + random.GetValue(-spread, spread);
+
+		PhysBody* body;
+		int sprite;
+
+		if (i % 2 == 0)
+		{
+			body = App->physics->CreateRectangle(x, y, 30, 30);
+			sprite = box;
+		}
+		else
+		{
+			body = App->physics->CreateCircle(x, y, 14);
+			sprite = circle;
+		}
+
+		entities.emplace_back(new Debris(App->renderer, App->physics, body, this, sprite));
+	}
+}
+
+void ModuleGame::RunBenchmarks(const char* path)
+{
+	static const int car_counts[] = { 1, 6, 32, 128 };
+
+	// Whole map, a bit past the walls of CreateMapBorders()
+	b2AABB view;
+	view.lowerBound.Set(PIXEL_TO_METERS(800), PIXEL_TO_METERS(480));
+	view.upperBound.Set(PIXEL_TO_METERS(3340), PIXEL_TO_METERS(2730));
+
+	Benchmark bench;
+
+	for (int mapId = 1; mapId <= MAP_COUNT; ++mapId)
+	{
+		CreateMapBorders();
+		LoadWaypoints(mapId, false);
+
+		for (int count : car_counts)
+		{
+			if (waypoints.empty())
+				break;
+
+			SpawnCarsAlongTrack(count, 0);
+
+			std::vector<Car*> cars;
+			for (PhysicEntity* entity : entities)
+			{
+				Car* car = dynamic_cast<Car*>(entity);
+				if (car) cars.push_back(car);
+			}
+
+			// Two seconds of driving so the rigs are moving and spread out. Sleeping
+			// is off, a step with every body asleep would measure nothing
+			for (int tick = 0; tick < 2 * PHYSICS_TICK_RATE; ++tick)
+			{
+				for (Car* car : cars)
+				{
+					car->GoToWaypoint(waypoints[car->currentWaypoint]);
+					car->UpdateWaypointProgress();
+					car->FixedUpdate();
+				}
+				App->physics->StepWorld();
+			}
+
+			for (Car* car : cars)
+			{
+				car->body->body->SetSleepingAllowed(false);
+				car->frontLeft->body->body->SetSleepingAllowed(false);
+				car->frontRight->body->body->SetSleepingAllowed(false);
+				car->rearLeft->body->body->SetSleepingAllowed(false);
+				car->rearRight->body->body->SetSleepingAllowed(false);
+			}
+
+			bench.Run("world_step", mapId, count, 1, [&]() {
+				App->physics->StepWorld();
+			});
+
+			bench.Run("update_tire", mapId, count, count * 4, [&]() {
+				for (Car* car : cars) car->FixedUpdate();
+			});
+
+			bench.Run("go_to_waypoint", mapId, count, count, [&]() {
+				for (Car* car : cars) car->GoToWaypoint(waypoints[car->currentWaypoint]);
+			});
+
+			bench.Run("update_leaderboard", mapId, count, 1, [&]() {
+				UpdateLeaderboard();
+			});
+
+			bench.Run("debug_draw", mapId, count, 1, [&]() {
+				App->physics->BuildDebugDraw(view, Vector2{ 0.0f, 0.0f });
+			});
+
+			DeleteRace();
+		}
+
+		DeleteMap();
+	}
+
+	bench.Save(path);
+}
+
+// The run starts with the state change, so the grid start and the frames
+// loading the map are measured too
+bool ModuleGame::StartNextPerfRace()
+{
+	while (++perf_map <= MAP_COUNT)
+	{
+		std::string path = "Assets/Map" + std::to_string(perf_map) + "/" + PERF_RACE_FILE;
+
+		if (!FileExists(path.c_str()) || !input_log.Load(path.c_str(), MAP_COUNT))
+		{
+			LOG("Perf: no recorded race for map %d", perf_map);
+			continue;
+		}
+
+		replaying = true;
+		App->state->mapId = input_log.GetMapId();
+		App->state->ChangeState(GameState::RACE);
+		App->perf.BeginRun(TextFormat("map%d", perf_map));
+
+		return true;
+	}
+
+	return false;
+}
+
+update_status ModuleGame::FinishPerfRaces()
+{
+	if (App->perf.GetRuns().empty())
+	{
+		App->perf_failed = true;
+	}
+	else if (FileExists(App->perf_baseline.c_str()))
+	{
+		App->perf_failed = !App->perf.Compare(App->perf_baseline.c_str());
+	}
+	else if (App->perf.Save(App->perf_baseline.c_str()))
+	{
+		printf("Perf baseline written: %s\n", App->perf_baseline.c_str());
+	}
+
+	return UPDATE_STOP;
+}
+
+bool ModuleGame::IsReplayOver() const
+{
+	return replaying && input_log.IsFinished(race_tick);
+}
+
+uint32 ModuleGame::HashRaceState() const
+{
+	uint32 header[2] = { race_tick, random.GetState() };
+	uint64 hash = StateTrace::Hash(header, sizeof(header));
+
+	for (PhysicEntity* entity : entities)
+	{
+		Car* car = dynamic_cast<Car*>(entity);
+		if (!car) continue;
+
+		int state[4] = { car->id, car->currentWaypoint, car->currentLap, car->raceFinished ? 1 : 0 };
+		hash = StateTrace::Hash(state, sizeof(state), hash);
+	}
+
+	return StateTrace::Fold(hash);
+}
+
+RaceSplit ModuleGame::GetLastSplit() const
+{
+	for (PhysicEntity* entity : entities)
+	{
+		Car* car = dynamic_cast<Car*>(entity);
+		if (car && car->isplayer)
+			return car->lastSplit;
+	}
+	return RaceSplit();
+}
+
 double ModuleGame::GetRaceTime() const
 {
 	for (PhysicEntity* entity : entities)
 	{
 		Car* car = dynamic_cast<Car*>(entity);
 		if (car && car->isplayer)
-			return car->raceTimer.ReadSec();
+			return ModulePhysics::TicksToSeconds(car->raceFinished ? car->finishTick : (double)race_tick);
 	}
 	return 0.0;
 }
\ No newline at end of file
@@ -4,14 +4,81 @@
 #include "Module.h"
 
 #include "p2Point.h"
+#include "GameRandom.h"
+#include "InputLog.h"
+#include "Telemetry.h"
+#include "RaceReplay.h"
+#include "GhostTrack.h"
 
 #include "raylib.h"
 #include <vector>
 #include <set>
+#include <string>
+#include <string.h>
+
+#define RACE_CAR_COUNT 6
+#define RACE_LAP_COUNT 3
+#define RACE_SPLIT_SHOW_SECONDS 3.0		// the race UI shows a checkpoint split this long
+
+#define STRESS_MIN_CARS 10
+#define STRESS_MAX_CARS 1000
 
 class PhysBody;
 class PhysicEntity;
 
+// Grid and car parameters read from Map.txt
+struct MapLayout
+{
+	int start_x = 0;
+	int start_y = 0;
+	int car_w = 50;
+	int car_h = 100;
+	float car_scale = 1.0f;
+	int car_dir = 0;
+};
+
+// --stress: extra AI cars and debris on top of the normal grid, and switches to
+// leave a subsystem out so each one's scaling can be measured on its own
+struct StressConfig
+{
+	int cars = 0;				// 0 is a normal race
+	int debris = 0;
+	bool physics = true;		// tire forces and world steps
+	bool ai = true;				// GoToWaypoint of every AI car
+	bool render = true;			// car and debris sprites
+	bool audio = true;			// engine voices
+
+	bool Disable(const char* subsystem)
+	{
+		if (strcmp(subsystem, "physics") == 0) physics = false;
+		else if (strcmp(subsystem, "ai") == 0) ai = false;
+		else if (strcmp(subsystem, "render") == 0) render = false;
+		else if (strcmp(subsystem, "audio") == 0) audio = false;
+		else return false;
+
+		return true;
+	}
+};
+
+// Leaderboard sort key of one car, kept in a member so the sort never allocates
+struct CarProgress
+{
+	int id;
+	int waypoint;
+	int lap;
+	float distToNext;
+};
+
+// Time at one checkpoint, on the same sub-tick crossing as the lap times
+struct RaceSplit
+{
+	int checkpoint = -1;		// waypoint index in the lap, -1 before the first one
+	double time = 0.0;			// seconds into the lap
+	double delta = 0.0;			// against the same checkpoint of the best lap
+	bool has_delta = false;		// false until a full lap is done
+	double tick = 0.0;			// race clock tick of the crossing
+};
+
 struct RaceResults
 {
 	std::vector<int> finalLeaderboard;
@@ -27,6 +94,7 @@ public:
 
 	bool Start();
 	update_status Update();
+	void FixedUpdate();
 	bool CleanUp();
 	void CreateCar(int x, int y, int w, int h, float scale, int dir, bool playable, int id);
 	void CreateRace(int x, int y, int w, int h, float scale, int dir);
@@ -50,7 +118,39 @@ public:
 
 	void DeleteMap();
 
+	// AI cars in three lanes along the waypoint centreline, ids from first_id. Rows
+	// stay a car length apart and off the grid, a count past that is cut down
+	void SpawnCarsAlongTrack(int count, int first_id);
+
+	// Crates and barrels scattered over the track with the race RNG
+	void SpawnDebris(int count);
+
+	// --bench: times the physics, AI and leaderboard paths on every map and saves JSON
+	void RunBenchmarks(const char* path);
+
+	// --perf: replays the PERF_RACE_FILE of each map, then compares or writes the baseline
+	bool StartNextPerfRace();
+	update_status FinishPerfRaces();
+
 	double GetRaceTime() const;
+	RaceSplit GetLastSplit() const;		// of the player
+
+	// Laps, waypoints, tick and rng state folded into one value for StateTrace
+	uint32 HashRaceState() const;
+
+	// A replayed race keeps running past the end of its input log, the ticks
+	// after it were never recorded and stay out of the trace
+	bool IsReplayOver() const;
+
+	// Results screen replay viewer, draws the recorded transforms instead of the world
+	void StartReplayViewer();
+	void StopReplayViewer();
+	void UpdateReplayViewer();
+
+	// Best lap ghosts of the map, drawn as sprites only, never added to the world
+	void LoadGhosts(int mapId);
+	void RecordGhostLap(const ReplayTransform& transform, bool lap_completed);
+	void DrawGhosts();
 
 public:
 
@@ -59,14 +159,14 @@ public:
 	PhysBody* sensor;
 	bool sensed;
 
-	Texture2D circle;
-	Texture2D box;
-	Texture2D rick;
+	// Atlas sprite handles (see ModuleRender::LoadSprite)
+	int circle;
+	int box;
+	int rick;
 	Texture2D map;
-	Texture2D wheel;
-	Texture2D carT;
+	int wheel;
+	int carT;
 	uint32 lap_fx;
-	uint32 accelerate_fx;
 
 	bool onRace = false;
 	bool onMenu = true;
@@ -81,6 +181,37 @@ public:
 	std::vector<PhysBody*> mapBodies;
 	std::set<std::set<PhysicEntity*>> collidingEntities;
 	std::vector<int> leaderboard;
+	std::vector<CarProgress> leaderboard_progress;
 
 	RaceResults results;
+	MapLayout layout;
+
+	// Deterministic races: input keyed by physics tick and the RNG seed
+	GameRandom random;
+	InputLog input_log;
+	std::string replay_file;
+	bool replaying = false;
+	uint32 race_tick = 0;
+	uint32 player_input = 0;
+
+	// --telemetry <file> records every car on every race tick
+	Telemetry telemetry;
+	std::string telemetry_file;
+
+	std::string bench_file;
+	StressConfig stress;
+	int perf_map = 0;
+
+	// Transforms of the last race, seekable without stepping the world
+	RaceReplay replay;
+	std::vector<ReplayTransform> replay_frame;
+	bool viewing_replay = false;
+	bool replay_paused = false;
+	float replay_tick = 0.0f;
+
+	// Player lap being recorded and every ghost found in the map folder
+	GhostTrack ghost_lap;
+	std::vector<GhostTrack> ghosts;
+	int best_ghost = -1;
+	uint32 lap_start_tick = 0;
 };
@@ -28,7 +28,6 @@ ModulePhysics::ModulePhysics(Application* app, bool start_enabled) : Module(app,
 {
 	world = NULL;
 	mouse_joint = NULL;
-	debug = true;
 }
 
 // Destructor
@@ -40,25 +39,61 @@ bool ModulePhysics::Start()
 {
 	LOG("Creating Physics 2D environment");
 
+	CreateWorld();
+
+	return true;
+}
+
+void ModulePhysics::CreateWorld()
+{
 	world = new b2World(b2Vec2(GRAVITY_X, -GRAVITY_Y));
 	world->SetContactListener(this);
+	world->SetDebugDraw(&debug_draw);
 	b2BodyDef bd;
 	ground = world->CreateBody(&bd);
+	mouse_joint = nullptr;
+}
 
-	return true;
+void ModulePhysics::ResetWorld()
+{
+	// The ground body is the only one the world should still hold
+	if (world->GetBodyCount() > 1)
+	{
+		LOG("Resetting the physics world with %d bodies still alive", world->GetBodyCount() - 1);
+	}
+
+	delete world;
+	CreateWorld();
+	accumulator = 0.0f;
+
+	// Like the input log, the trace keeps the latest race only
+	if (!trace_file.empty())
+		trace.Open(trace_file.c_str());
 }
 
 update_status ModulePhysics::PreUpdate()
 {
 	accumulator += App->deltaTime;
 
-	const float timeStep = 1.0f / 60.0f;
-	const int velocityIterations = 6;
-	const int positionIterations = 2;
+	const float timeStep = PHYSICS_TIMESTEP;
+
+	// A throttled menu steps once per rendered frame, its background cars slow
+	// down instead of catching up on every tick of the idle frame
+	if (App->IsThrottled())
+		accumulator = MIN(accumulator, timeStep);
 
 	while (accumulator >= timeStep)
 	{
-		world->Step(timeStep, velocityIterations, positionIterations);
+		bool traced = trace.IsOpen() && App->scene_intro->onRace && !App->scene_intro->IsReplayOver();
+
+		App->scene_intro->FixedUpdate();
+
+		if (App->scene_intro->stress.physics)
+			StepWorld();
+
+		if (traced)
+			trace.Record(App->scene_intro->race_tick, world, App->scene_intro->HashRaceState());
+
 		accumulator -= timeStep;
 	}
 
@@ -79,6 +114,29 @@ update_status ModulePhysics::PreUpdate()
 	return UPDATE_CONTINUE;
 }
 
+double ModulePhysics::TicksToSeconds(double ticks)
+{
+	return ticks / PHYSICS_TICK_RATE;
+}
+
+void ModulePhysics::StepWorld()
+{
+	const int velocityIterations = 6;
+	const int positionIterations = 2;
+
+	world->Step(PHYSICS_TIMESTEP, velocityIterations, positionIterations);
+}
+
+uint ModulePhysics::GetBodyCount() const
+{
+	return (uint)world->GetBodyCount();
+}
+
+uint ModulePhysics::GetContactCount() const
+{
+	return (uint)world->GetContactCount();
+}
+
 PhysBody* ModulePhysics::CreateCircle(int x, int y, int radius)
 {
 	PhysBody* pbody = new PhysBody();
@@ -502,102 +560,50 @@ void ModulePhysics::DeleteBody(PhysBody* body)
 	delete body;
 }
 
-// 
+// Debug draw only walks what the camera sees: F2 joints, F3 AABBs, F4 contacts
 update_status ModulePhysics::PostUpdate()
 {
-	if (IsKeyPressed(KEY_F1))
-	{
-		debug = !debug;
-	}
+	if (IsKeyPressed(KEY_F2)) ToggleDebugFlag(b2Draw::e_jointBit);
+	if (IsKeyPressed(KEY_F3)) ToggleDebugFlag(b2Draw::e_aabbBit);
+	if (IsKeyPressed(KEY_F4)) ToggleDebugFlag(b2Draw::e_pairBit);
 
-	if (!debug)
+	if (!App->scene_intro->debug)
 	{
 		return UPDATE_CONTINUE;
 	}
 
-	// Bonus code: this will iterate all objects in the world and draw the circles
-	// You need to provide your own macro to translate meters to pixels
-	if(App->scene_intro->debug){
-		for (b2Body* b = world->GetBodyList(); b; b = b->GetNext())
-		{
-			for (b2Fixture* f = b->GetFixtureList(); f; f = f->GetNext())
-			{
-				switch (f->GetType())
-				{
-					// Draw circles ------------------------------------------------
-				case b2Shape::e_circle:
-				{
-					b2CircleShape* shape = (b2CircleShape*)f->GetShape();
-					b2Vec2 pos = f->GetBody()->GetPosition();
-
-					DrawCircle(METERS_TO_PIXELS(pos.x), METERS_TO_PIXELS(pos.y), (float)METERS_TO_PIXELS(shape->m_radius), Color{ 0, 0, 0, 128 });
-				}
-				break;
-
-				// Draw polygons ------------------------------------------------
-				case b2Shape::e_polygon:
-				{
-					b2PolygonShape* polygonShape = (b2PolygonShape*)f->GetShape();
-					int32 count = polygonShape->m_count;
-					b2Vec2 prev, v;
-
-					for (int32 i = 0; i < count; ++i)
-					{
-						v = b->GetWorldPoint(polygonShape->m_vertices[i]);
-						if (i > 0)
-							DrawLine(METERS_TO_PIXELS(prev.x) + App->renderer->camera.x, METERS_TO_PIXELS(prev.y) + App->renderer->camera.y, METERS_TO_PIXELS(v.x) + App->renderer->camera.x, METERS_TO_PIXELS(v.y) + App->renderer->camera.y, RED);
-
-						prev = v;
-					}
-
-					v = b->GetWorldPoint(polygonShape->m_vertices[0]);
-					DrawLine(METERS_TO_PIXELS(prev.x) + App->renderer->camera.x, METERS_TO_PIXELS(prev.y) + App->renderer->camera.y, METERS_TO_PIXELS(v.x) + App->renderer->camera.x, METERS_TO_PIXELS(v.y) + App->renderer->camera.y, RED);
-				}
-				break;
-
-				// Draw chains contour -------------------------------------------
-				case b2Shape::e_chain:
-				{
-					b2ChainShape* shape = (b2ChainShape*)f->GetShape();
-					b2Vec2 prev, v;
-
-					for (int32 i = 0; i < shape->m_count; ++i)
-					{
-						v = b->GetWorldPoint(shape->m_vertices[i]);
-						if (i > 0)
-							DrawLine(METERS_TO_PIXELS(prev.x), METERS_TO_PIXELS(prev.y), METERS_TO_PIXELS(v.x), METERS_TO_PIXELS(v.y), GREEN);
-						prev = v;
-					}
-
-					v = b->GetWorldPoint(shape->m_vertices[0]);
-					DrawLine(METERS_TO_PIXELS(prev.x), METERS_TO_PIXELS(prev.y), METERS_TO_PIXELS(v.x), METERS_TO_PIXELS(v.y), GREEN);
-				}
-				break;
-
-				// Draw a single segment(edge) ----------------------------------
-				case b2Shape::e_edge:
-				{
-					b2EdgeShape* shape = (b2EdgeShape*)f->GetShape();
-					b2Vec2 v1, v2;
-
-					v1 = b->GetWorldPoint(shape->m_vertex0);
-					v1 = b->GetWorldPoint(shape->m_vertex1);
-					DrawLine(METERS_TO_PIXELS(v1.x), METERS_TO_PIXELS(v1.y), METERS_TO_PIXELS(v2.x), METERS_TO_PIXELS(v2.y), BLUE);
-				}
-				break;
-				}
-			}
-		}
-	}
+	Rectangle& camera = App->renderer->camera;
+
+	b2AABB view;
+	view.lowerBound.Set(PIXEL_TO_METERS(-camera.x), PIXEL_TO_METERS(-camera.y));
+	view.upperBound.Set(PIXEL_TO_METERS(SCREEN_WIDTH - camera.x), PIXEL_TO_METERS(SCREEN_HEIGHT - camera.y));
+
+	BuildDebugDraw(view, Vector2{ camera.x, camera.y });
+	App->renderer->DrawLines(debug_draw.GetLines(), debug_draw.GetLineCount(), LAYER_DEBUG);
+
 	return UPDATE_CONTINUE;
 }
 
+const PhysicsDebugDraw& ModulePhysics::BuildDebugDraw(const b2AABB& view, Vector2 offset)
+{
+	debug_draw.DrawWorld(world, view, offset);
+	return debug_draw;
+}
+
+void ModulePhysics::ToggleDebugFlag(uint32 flag)
+{
+	uint32 flags = debug_draw.GetFlags();
+	debug_draw.SetFlags((flags & flag) ? (flags & ~flag) : (flags | flag));
+}
+
 
 // Called before quitting
 bool ModulePhysics::CleanUp()
 {
 	LOG("Destroying physics world");
 
+	trace.Close();
+
 	// Delete the whole physics world!
 	delete world;
 
@@ -755,7 +761,7 @@ void ModulePhysics::DrawMouseJointDebug()
 		METERS_TO_PIXELS(p2.y) + App->renderer->camera.y
 	};
 
-	DrawLineV(a, b, RED);
-	DrawCircleV(a, 4, RED);
-	DrawCircleV(b, 4, RED);
+	App->renderer->DrawLineV(a, b, RED, LAYER_DEBUG);
+	App->renderer->DrawCircleV(a, 4, RED, LAYER_DEBUG);
+	App->renderer->DrawCircleV(b, 4, RED, LAYER_DEBUG);
 }
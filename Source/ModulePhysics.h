@@ -4,6 +4,10 @@
 #include "Globals.h"
 
 #include "box2d\box2d.h"
+#include "PhysicsDebugDraw.h"
+#include "StateTrace.h"
+
+#include <string>
 
 #define GRAVITY_X 0.0f
 #define GRAVITY_Y -7.0f
@@ -11,6 +15,9 @@
 #define PIXELS_PER_METER 50.0f // if touched change METER_PER_PIXEL too
 #define METER_PER_PIXEL 0.02f // this is 1 / PIXELS_PER_METER !
 
+#define PHYSICS_TICK_RATE 60
+#define PHYSICS_TIMESTEP (1.0f / PHYSICS_TICK_RATE)
+
 #define METERS_TO_PIXELS(m) ((int) floor(PIXELS_PER_METER * m))
 #define PIXEL_TO_METERS(p)  ((float) METER_PER_PIXEL * p)
 
@@ -74,9 +81,34 @@ public:
 
 	void EndMouseDrag();
 	void DrawMouseJointDebug();
+
+	// Race and lap times are counted in world steps, never in wall time
+	static double TicksToSeconds(double ticks);
+
+	// One fixed step of the world, without the game FixedUpdate() around it
+	void StepWorld();
+
+	// Drops the world and starts an empty one, so every race (recorded or
+	// replayed) steps the same broad-phase and contact order. Every PhysBody
+	// must be deleted before, the ones left behind are dangling after this
+	void ResetWorld();
+
+	uint GetBodyCount() const;
+	uint GetContactCount() const;
+
+	// Fills the debug line list for the view (meters), PostUpdate() draws it
+	const PhysicsDebugDraw& BuildDebugDraw(const b2AABB& view, Vector2 offset);
+
+	// --trace <file> writes a StateTrace of every tick of the latest race
+	std::string trace_file;
+
 private:
+	void ToggleDebugFlag(uint32 flag);
+	void CreateWorld();
+
 	float accumulator = 0.0f;
-	bool debug;
+	PhysicsDebugDraw debug_draw;
+	StateTrace trace;
 	b2World* world;
 	b2MouseJoint* mouse_joint;
 	b2Body* ground;
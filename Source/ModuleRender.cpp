@@ -4,7 +4,9 @@
 #include "ModuleRender.h"
 #include "ModuleState.h"
 #include "ModuleGame.h"
+#include "MemoryTracker.h"
 #include <math.h>
+#include <string.h>
 
 ModuleRender::ModuleRender(Application* app, bool start_enabled) : Module(app, start_enabled)
 {
@@ -23,9 +25,31 @@ bool ModuleRender::Init()
 
     fuente = LoadFont("Assets/Fonts/Racesky.otf");
 
+    world_target = LoadRenderTexture(SCREEN_WIDTH, SCREEN_HEIGHT);
+    if (world_target.id == 0)
+    {
+        LOG("Cannot create world render target, dynamic resolution disabled");
+        dynamic_resolution = false;
+    }
+    else SetTextureFilter(world_target.texture, TEXTURE_FILTER_BILINEAR);
+
+    // Without timer queries the scale follows the CPU work alone
+    for (int i = 0; i < RENDER_GPU_TIMERS && dynamic_resolution; ++i)
+        gpu_timers[i] = rlLoadGpuTimer();
+
+    ui_target = LoadRenderTexture(SCREEN_WIDTH, SCREEN_HEIGHT);
+    if (ui_target.id == 0)
+        LOG("Cannot create UI render target, widgets are drawn every frame");
+
 	return ret;
 }
 
+// Called after every module has requested its sprites
+bool ModuleRender::Start()
+{
+	return atlas.Build();
+}
+
 // PreUpdate: clear buffer
 update_status ModuleRender::PreUpdate()
 {
@@ -35,24 +59,46 @@ update_status ModuleRender::PreUpdate()
 // Update: debug camera
 update_status ModuleRender::Update()
 {
-    ClearBackground(background);
+	return UPDATE_CONTINUE;
+}
 
+// PostUpdate present buffer to screen
+update_status ModuleRender::PostUpdate()
+{
     // NOTE: This function setups render batching system for
     // maximum performance, all consecutive Draw() calls are
     // not processed until EndDrawing() is called
+    UpdateRenderScale();
+
     BeginDrawing();
+    ClearBackground(background);
+    BeginGpuTimer();
 
-	return UPDATE_CONTINUE;
-}
+    // Every module has queued its frame by now, sort and draw it in one go
+    FlushQueue();
+
+    stats.text_runs = text_cache.GetRunCount();
+    stats.text_built = text_cache.GetBuiltThisFrame();
+    text_cache.EndFrame();
 
-// PostUpdate present buffer to screen
-update_status ModuleRender::PostUpdate()
-{
-    // Draw everything in our batch!
     if (App->scene_intro->debug) {
         DrawFPS(10, 10);
+        ::DrawText(TextFormat("CMDS %u  CULLED %u  TEX %u  SCALE %d%%  TEXT %u (+%u)  UI %u (%u)  ACT %u/%u", stats.commands, stats.culled, stats.texture_switches, (int)(render_scale * 100.0f + 0.5f), stats.text_runs, stats.text_built, stats.ui_widgets, stats.ui_redrawn, App->GetFrameActivity().rendered, App->GetFrameActivity().skipped), 10, 32, 10, LIME);
+
+        // Live / peak MB and allocations of the last frame, red past the tag budget
+        int mem_x = 10;
+        for (int tag = 0; tag < MEMORY_TAGS; ++tag)
+        {
+            MemoryStats mem = MemoryTracker::GetStats((MemoryTag)tag);
+            const char* text = TextFormat("%s %.1f/%.1f MB %u/f", MemoryTracker::GetTagName((MemoryTag)tag),
+                mem.live_bytes / (1024.0 * 1024.0), mem.peak_bytes / (1024.0 * 1024.0), mem.frame_allocs);
+
+            ::DrawText(text, mem_x, 44, 10, (mem.live_bytes > MemoryTracker::GetBudget((MemoryTag)tag)) ? RED : LIME);
+            mem_x += MeasureText(text, 10) + 16;
+        }
     }
-    
+
+    MeasureWorkTime();
     EndDrawing();
 
 	return UPDATE_CONTINUE;
@@ -61,6 +107,20 @@ update_status ModuleRender::PostUpdate()
 // Called before quitting
 bool ModuleRender::CleanUp()
 {
+	atlas.Unload();
+	text_cache.Clear();
+
+	if (world_target.id != 0)
+		UnloadRenderTexture(world_target);
+
+	if (ui_target.id != 0)
+		UnloadRenderTexture(ui_target);
+
+	for (int i = 0; i < RENDER_GPU_TIMERS; ++i)
+		rlUnloadGpuTimer(gpu_timers[i]);
+
+	ui_layer.Clear();
+
 	return true;
 }
 
@@ -70,7 +130,7 @@ void ModuleRender::SetBackgroundColor(Color color)
 }
 
 // Draw to screen
-bool ModuleRender::Draw(Texture2D texture, int x, int y, const Rectangle* section, double angle, int pivot_x, int pivot_y, float scale) const
+bool ModuleRender::Draw(Texture2D texture, int x, int y, const Rectangle* section, double angle, int pivot_x, int pivot_y, float scale, RenderLayer layer, Color tint)
 {
 	bool ret = true;
 
@@ -78,6 +138,7 @@ bool ModuleRender::Draw(Texture2D texture, int x, int y, const Rectangle* sectio
 
     // Rectngulo de origen
     Rectangle src = { 0.f, 0.f, (float)texture.width, (float)texture.height };
+    if (section != NULL) src = *section;
    
     // Rectngulo de destino: posicin del sprite (coincide con el cuerpo)
     Rectangle dest = {
@@ -90,13 +151,34 @@ bool ModuleRender::Draw(Texture2D texture, int x, int y, const Rectangle* sectio
     // Pivot: punto de rotacin dentro del sprite
     Vector2 origin = { (float)pivot_x, (float)pivot_y };
 
-    DrawTexturePro(texture, src, dest, origin, (float)angle, WHITE);
+    DrawTexturePro(texture, src, dest, origin, (float)angle, tint, layer);
 
 	return ret;
 }
 
 
-bool ModuleRender::DrawText(const char * text, int x, int y, Font font, int spacing, Color tint) const
+int ModuleRender::LoadSprite(const char* path)
+{
+	return atlas.Add(path);
+}
+
+Rectangle ModuleRender::GetSpriteSection(int sprite) const
+{
+	return atlas.GetSection(sprite);
+}
+
+// Draw a packed sprite, all sprites of the same page share one draw call
+bool ModuleRender::DrawSprite(int sprite, int x, int y, double angle, int pivot_x, int pivot_y, float scale, RenderLayer layer, Color tint)
+{
+	Texture2D page = atlas.GetTexture(sprite);
+	if (page.id == 0)
+		return false;
+
+	Rectangle section = atlas.GetSection(sprite);
+	return Draw(page, x, y, &section, angle, pivot_x, pivot_y, scale, layer, tint);
+}
+
+bool ModuleRender::DrawText(const char * text, int x, int y, Font font, int spacing, Color tint)
 {
     bool ret = true;
 
@@ -124,4 +206,709 @@ void ModuleRender::DrawUIButton(int x, int y, int w, int h, const char* text, bo
         20, 
         BLACK
     );
-}
\ No newline at end of file
+}
+
+// Render queue ---------------------------------------------------------------
+
+RenderCommand& ModuleRender::Push(RenderCommandType type, RenderLayer layer, Color tint)
+{
+	// UI draws issued inside a widget are retained by the widget instead
+	UIWidget* widget = (layer == LAYER_UI && type != RENDER_LINES) ? ui_layer.GetRecording() : NULL;
+	std::vector<RenderCommand>& queue = (widget != NULL) ? widget->commands : commands;
+
+	queue.emplace_back();
+
+	RenderCommand& command = queue.back();
+	command.type = (uchar)type;
+	command.layer = (uchar)layer;
+	command.tint = tint;
+	command.texture = Texture2D{ 0 };
+	command.source = Rectangle{ 0.0f, 0.0f, 0.0f, 0.0f };
+	command.origin = Vector2{ 0.0f, 0.0f };
+	command.rotation = 0.0f;
+	command.payload = 0;
+
+	return command;
+}
+
+void ModuleRender::DrawText(const char* text, int x, int y, int font_size, Color color, RenderLayer layer)
+{
+	// Same spacing rule raylib uses for its default font
+	const int default_size = 10;
+	if (font_size < default_size) font_size = default_size;
+
+	DrawTextEx(GetFontDefault(), text, Vector2{ (float)x, (float)y }, (float)font_size, (float)(font_size / default_size), color, layer);
+}
+
+void ModuleRender::DrawTextEx(Font font, const char* text, Vector2 position, float font_size, float spacing, Color tint, RenderLayer layer)
+{
+	if (text == NULL || text[0] == '\0')
+		return;
+
+	if (font.texture.id == 0) font = GetFontDefault();
+
+	UIWidget* widget = (layer == LAYER_UI) ? ui_layer.GetRecording() : NULL;
+
+	RenderCommand& command = Push(RENDER_TEXT, layer, tint);
+	command.texture = font.texture;
+	command.dest = Rectangle{ position.x, position.y, 0.0f, 0.0f };
+
+	if (widget != NULL)
+	{
+		// Retained widgets outlive the text cache handles, keep the string and resolve it on replay
+		command.payload = (uint)widget->texts.size();
+		widget->texts.push_back({ font, font_size, spacing, text });
+	}
+	else
+	{
+		// Layout happens once per distinct string, the command only keeps the run handle
+		command.payload = (uint)text_cache.GetRun(font, text, font_size, spacing);
+	}
+}
+
+int ModuleRender::MeasureText(const char* text, int font_size)
+{
+	const int default_size = 10;
+	if (font_size < default_size) font_size = default_size;
+
+	return (int)text_cache.Measure(GetFontDefault(), text, (float)font_size, (float)(font_size / default_size)).x;
+}
+
+Vector2 ModuleRender::MeasureTextEx(Font font, const char* text, float font_size, float spacing)
+{
+	return text_cache.Measure(font, text, font_size, spacing);
+}
+
+void ModuleRender::DrawTexturePro(Texture2D texture, Rectangle source, Rectangle dest, Vector2 origin, float rotation, Color tint, RenderLayer layer)
+{
+	if (texture.id == 0)
+		return;
+
+	RenderCommand& command = Push(RENDER_TEXTURE, layer, tint);
+	command.texture = texture;
+	command.source = source;
+	command.dest = dest;
+	command.origin = origin;
+	command.rotation = rotation;
+}
+
+void ModuleRender::DrawLine(int start_x, int start_y, int end_x, int end_y, Color color, RenderLayer layer)
+{
+	DrawLineV(Vector2{ (float)start_x, (float)start_y }, Vector2{ (float)end_x, (float)end_y }, color, layer);
+}
+
+void ModuleRender::DrawLineV(Vector2 start, Vector2 end, Color color, RenderLayer layer)
+{
+	RenderCommand& command = Push(RENDER_LINE, layer, color);
+	command.dest = Rectangle{ start.x, start.y, end.x, end.y };
+}
+
+void ModuleRender::DrawRectangle(int x, int y, int width, int height, Color color, RenderLayer layer)
+{
+	DrawRectanglePro(Rectangle{ (float)x, (float)y, (float)width, (float)height }, Vector2{ 0.0f, 0.0f }, 0.0f, color, layer);
+}
+
+void ModuleRender::DrawRectangleRec(Rectangle rec, Color color, RenderLayer layer)
+{
+	DrawRectanglePro(rec, Vector2{ 0.0f, 0.0f }, 0.0f, color, layer);
+}
+
+void ModuleRender::DrawRectanglePro(Rectangle rec, Vector2 origin, float rotation, Color color, RenderLayer layer)
+{
+	RenderCommand& command = Push(RENDER_RECTANGLE, layer, color);
+	command.dest = rec;
+	command.origin = origin;
+	command.rotation = rotation;
+}
+
+void ModuleRender::DrawRectangleLines(int x, int y, int width, int height, Color color, RenderLayer layer)
+{
+	// Zero thickness keeps raylib's one pixel outline
+	DrawRectangleLinesEx(Rectangle{ (float)x, (float)y, (float)width, (float)height }, 0.0f, color, layer);
+}
+
+void ModuleRender::DrawRectangleLinesEx(Rectangle rec, float thick, Color color, RenderLayer layer)
+{
+	RenderCommand& command = Push(RENDER_RECTANGLE_LINES, layer, color);
+	command.dest = rec;
+	command.rotation = thick;
+}
+
+void ModuleRender::DrawCircle(int x, int y, float radius, Color color, RenderLayer layer)
+{
+	DrawCircleV(Vector2{ (float)x, (float)y }, radius, color, layer);
+}
+
+void ModuleRender::DrawCircleV(Vector2 center, float radius, Color color, RenderLayer layer)
+{
+	RenderCommand& command = Push(RENDER_CIRCLE, layer, color);
+	command.dest = Rectangle{ center.x, center.y, radius, radius };
+}
+
+void ModuleRender::DrawLines(const rlLine* lines, int count, RenderLayer layer)
+{
+	if (count <= 0)
+		return;
+
+	RenderCommand& command = Push(RENDER_LINES, layer, WHITE);
+	command.dest = Rectangle{ 0.0f, 0.0f, 0.0f, 0.0f };
+	command.payload = (uint)line_runs.size();
+
+	line_runs.push_back({ (uint)line_arena.size(), (uint)count });
+	line_arena.insert(line_arena.end(), lines, lines + count);
+}
+
+const RenderStats& ModuleRender::GetStats() const
+{
+	return stats;
+}
+
+bool ModuleRender::BeginWidget(uint64 id, Rectangle bounds, uint64 state)
+{
+	// Without the cached target every widget simply draws straight to the queue
+	if (ui_target.id == 0)
+		return true;
+
+	return ui_layer.BeginWidget(id, bounds, state);
+}
+
+void ModuleRender::EndWidget()
+{
+	ui_layer.EndWidget();
+}
+
+void ModuleRender::SetDynamicResolution(bool enabled)
+{
+	dynamic_resolution = enabled && world_target.id != 0;
+	render_scale = RENDER_SCALE_MAX;
+	scale_cooldown = 0;
+}
+
+float ModuleRender::GetRenderScale() const
+{
+	return dynamic_resolution ? render_scale : 1.0f;
+}
+
+// Stable LSD radix sort by (layer, texture): world layers get grouped by texture,
+// the UI layer only by layer so widgets keep their submission order
+void ModuleRender::SortQueue()
+{
+	uint count = (uint)commands.size();
+
+	sort_keys.resize(count);
+	sort_order.resize(count);
+	sort_keys_tmp.resize(count);
+	sort_order_tmp.resize(count);
+
+	for (uint i = 0; i < count; ++i)
+	{
+		const RenderCommand& command = commands[i];
+		uint texture = (command.layer < LAYER_DEBUG) ? (command.texture.id & 0xFFFF) : 0;
+
+		sort_keys[i] = ((uint)command.layer << 16) | texture;
+		sort_order[i] = i;
+	}
+
+	for (uint shift = 0; shift < 24; shift += 8)
+	{
+		uint offsets[256] = { 0 };
+
+		for (uint i = 0; i < count; ++i)
+			offsets[(sort_keys[i] >> shift) & 0xFF]++;
+
+		// Every key shares this digit, nothing to reorder
+		if (offsets[(sort_keys.empty() ? 0 : (sort_keys[0] >> shift) & 0xFF)] == count)
+			continue;
+
+		uint sum = 0;
+		for (uint d = 0; d < 256; ++d)
+		{
+			uint c = offsets[d];
+			offsets[d] = sum;
+			sum += c;
+		}
+
+		for (uint i = 0; i < count; ++i)
+		{
+			uint slot = offsets[(sort_keys[i] >> shift) & 0xFF]++;
+			sort_keys_tmp[slot] = sort_keys[i];
+			sort_order_tmp[slot] = sort_order[i];
+		}
+
+		sort_keys.swap(sort_keys_tmp);
+		sort_order.swap(sort_order_tmp);
+	}
+}
+
+// Conservative screen test for world space commands
+bool ModuleRender::IsCulled(const RenderCommand& command) const
+{
+	if (command.layer == LAYER_UI)
+		return false;
+
+	float min_x, min_y, max_x, max_y;
+
+	switch (command.type)
+	{
+	case RENDER_TEXTURE:
+	case RENDER_RECTANGLE:
+	{
+		// Bounding circle around the pivot covers any rotation
+		float ex = MAX(fabsf(command.origin.x), fabsf(command.dest.width - command.origin.x));
+		float ey = MAX(fabsf(command.origin.y), fabsf(command.dest.height - command.origin.y));
+		float radius = sqrtf(ex * ex + ey * ey);
+
+		min_x = command.dest.x - radius;
+		max_x = command.dest.x + radius;
+		min_y = command.dest.y - radius;
+		max_y = command.dest.y + radius;
+	}
+	break;
+
+	case RENDER_LINE:
+		min_x = MIN(command.dest.x, command.dest.width);
+		max_x = MAX(command.dest.x, command.dest.width);
+		min_y = MIN(command.dest.y, command.dest.height);
+		max_y = MAX(command.dest.y, command.dest.height);
+		break;
+
+	case RENDER_CIRCLE:
+		min_x = command.dest.x - command.dest.width;
+		max_x = command.dest.x + command.dest.width;
+		min_y = command.dest.y - command.dest.width;
+		max_y = command.dest.y + command.dest.width;
+		break;
+
+	default:
+		return false;
+	}
+
+	return max_x < 0.0f || max_y < 0.0f || min_x > (float)SCREEN_WIDTH || min_y > (float)SCREEN_HEIGHT;
+}
+
+void ModuleRender::Submit(const RenderCommand& command)
+{
+	switch (command.type)
+	{
+	case RENDER_TEXTURE:
+		BatchQuad(command);
+		break;
+
+	case RENDER_TEXT:
+		BatchText(command);
+		break;
+
+	case RENDER_LINE:
+		BatchLine(command);
+		break;
+
+	case RENDER_RECTANGLE:
+		::DrawRectanglePro(command.dest, command.origin, command.rotation, command.tint);
+		break;
+
+	case RENDER_RECTANGLE_LINES:
+		if (command.rotation <= 0.0f)
+			::DrawRectangleLines((int)command.dest.x, (int)command.dest.y, (int)command.dest.width, (int)command.dest.height, command.tint);
+		else
+			::DrawRectangleLinesEx(command.dest, command.rotation, command.tint);
+		break;
+
+	case RENDER_CIRCLE:
+		::DrawCircleV(Vector2{ command.dest.x, command.dest.y }, command.dest.width, command.tint);
+		break;
+
+	case RENDER_LINES:
+	{
+		if (!quad_batch.empty())
+			FlushBatches();
+
+		const LineRun& run = line_runs[command.payload];
+		line_batch.insert(line_batch.end(), line_arena.begin() + run.offset, line_arena.begin() + run.offset + run.count);
+	}
+	break;
+	}
+}
+
+// Same corner math as DrawTexturePro(), done here so the quad can go to rlgl in bulk
+void ModuleRender::BatchQuad(const RenderCommand& command)
+{
+	if (!line_batch.empty() || (quad_texture != command.texture.id && !quad_batch.empty()))
+		FlushBatches();
+
+	quad_texture = command.texture.id;
+
+	const Rectangle& dest = command.dest;
+	Rectangle source = command.source;
+	float width = (float)command.texture.width;
+	float height = (float)command.texture.height;
+
+	bool flip_x = false;
+	if (source.width < 0) { flip_x = true; source.width *= -1; }
+	if (source.height < 0) source.y -= source.height;
+
+	rlQuad quad;
+
+	if (command.rotation == 0.0f)
+	{
+		float x = dest.x - command.origin.x;
+		float y = dest.y - command.origin.y;
+
+		quad.x[0] = x;				quad.y[0] = y;
+		quad.x[1] = x;				quad.y[1] = y + dest.height;
+		quad.x[2] = x + dest.width;	quad.y[2] = y + dest.height;
+		quad.x[3] = x + dest.width;	quad.y[3] = y;
+	}
+	else
+	{
+		float s = sinf(command.rotation * DEG2RAD);
+		float c = cosf(command.rotation * DEG2RAD);
+		float dx = -command.origin.x;
+		float dy = -command.origin.y;
+
+		quad.x[0] = dest.x + dx * c - dy * s;
+		quad.y[0] = dest.y + dx * s + dy * c;
+		quad.x[1] = dest.x + dx * c - (dy + dest.height) * s;
+		quad.y[1] = dest.y + dx * s + (dy + dest.height) * c;
+		quad.x[2] = dest.x + (dx + dest.width) * c - (dy + dest.height) * s;
+		quad.y[2] = dest.y + (dx + dest.width) * s + (dy + dest.height) * c;
+		quad.x[3] = dest.x + (dx + dest.width) * c - dy * s;
+		quad.y[3] = dest.y + (dx + dest.width) * s + dy * c;
+	}
+
+	float u_left = source.x / width;
+	float u_right = (source.x + source.width) / width;
+
+	quad.u0 = flip_x ? u_right : u_left;
+	quad.u1 = flip_x ? u_left : u_right;
+	quad.v0 = source.y / height;
+	quad.v1 = (source.y + source.height) / height;
+
+	quad.color[0] = command.tint.r;
+	quad.color[1] = command.tint.g;
+	quad.color[2] = command.tint.b;
+	quad.color[3] = command.tint.a;
+
+	quad_batch.push_back(quad);
+}
+
+void ModuleRender::BatchLine(const RenderCommand& command)
+{
+	if (!quad_batch.empty())
+		FlushBatches();
+
+	rlLine line;
+	line.x0 = command.dest.x;
+	line.y0 = command.dest.y;
+	line.x1 = command.dest.width;
+	line.y1 = command.dest.height;
+	line.color[0] = command.tint.r;
+	line.color[1] = command.tint.g;
+	line.color[2] = command.tint.b;
+	line.color[3] = command.tint.a;
+
+	line_batch.push_back(line);
+}
+
+// Cached glyph quads are only offset and tinted, then joined to the quad batch
+void ModuleRender::BatchText(const RenderCommand& command)
+{
+	if (!line_batch.empty() || (quad_texture != command.texture.id && !quad_batch.empty()))
+		FlushBatches();
+
+	quad_texture = command.texture.id;
+
+	const TextRun& run = text_cache.GetRunData((int)command.payload);
+	size_t first = quad_batch.size();
+	quad_batch.insert(quad_batch.end(), run.quads.begin(), run.quads.end());
+
+	for (size_t i = first; i < quad_batch.size(); ++i)
+	{
+		rlQuad& quad = quad_batch[i];
+
+		for (int c = 0; c < 4; ++c)
+		{
+			quad.x[c] += command.dest.x;
+			quad.y[c] += command.dest.y;
+		}
+
+		quad.color[0] = command.tint.r;
+		quad.color[1] = command.tint.g;
+		quad.color[2] = command.tint.b;
+		quad.color[3] = command.tint.a;
+	}
+}
+
+void ModuleRender::FlushBatches()
+{
+	if (!quad_batch.empty())
+	{
+		rlDrawQuads(quad_texture, quad_batch.data(), (int)quad_batch.size());
+		quad_batch.clear();
+	}
+
+	if (!line_batch.empty())
+	{
+		rlDrawLines(line_batch.data(), (int)line_batch.size());
+		line_batch.clear();
+	}
+}
+
+void ModuleRender::FlushQueue()
+{
+	SortQueue();
+
+	stats.commands = (uint)commands.size();
+	stats.culled = 0;
+	stats.texture_switches = 0;
+
+	// Shapes are drawn with rlgl's default texture
+	uint texture_id = 0;
+
+	BeginWorldPass();
+	ui_composed = false;
+
+	for (uint index : sort_order)
+	{
+		const RenderCommand& command = commands[index];
+
+		// Queue is sorted by layer, the first UI command closes the world pass
+		// and puts the retained widgets below the immediate UI
+		if (!ui_composed && command.layer == LAYER_UI)
+		{
+			FlushBatches();
+			if (world_pass) EndWorldPass();
+			ComposeUI();
+		}
+
+		if (IsCulled(command))
+		{
+			stats.culled++;
+			continue;
+		}
+
+		uint id = (command.texture.id != 0) ? command.texture.id : rlGetTextureIdDefault();
+		if (id != texture_id)
+		{
+			stats.texture_switches++;
+			texture_id = id;
+		}
+
+		// Anything that is not a sprite or a line goes through raylib, keep the order
+		if (command.type != RENDER_TEXTURE && command.type != RENDER_TEXT && command.type != RENDER_LINE && command.type != RENDER_LINES)
+			FlushBatches();
+
+		Submit(command);
+	}
+
+	FlushBatches();
+
+	if (world_pass)
+		EndWorldPass();
+
+	if (!ui_composed)
+		ComposeUI();
+
+	commands.clear();
+	line_runs.clear();
+	line_arena.clear();
+}
+
+// Dynamic resolution ----------------------------------------------------------
+
+// Driven by the work time of the previous frames, see MeasureWorkTime(). Unlike
+// the frame delta it does not settle on the refresh interval under vsync
+void ModuleRender::UpdateRenderScale()
+{
+	if (!dynamic_resolution)
+		return;
+
+	work_time_avg = work_time_avg * 0.9f + MIN(work_time, 0.25f) * 0.1f;
+
+	if (scale_cooldown > 0)
+	{
+		scale_cooldown--;
+		return;
+	}
+
+	if (work_time_avg > RENDER_TARGET_FRAME_TIME * RENDER_SCALE_DOWN_LOAD && render_scale > RENDER_SCALE_MIN)
+	{
+		render_scale = MAX(render_scale - RENDER_SCALE_STEP, RENDER_SCALE_MIN);
+		scale_cooldown = RENDER_SCALE_DOWN_FRAMES;
+	}
+	else if (work_time_avg < RENDER_TARGET_FRAME_TIME * RENDER_SCALE_UP_LOAD && render_scale < RENDER_SCALE_MAX)
+	{
+		render_scale = MIN(render_scale + RENDER_SCALE_STEP, RENDER_SCALE_MAX);
+		scale_cooldown = RENDER_SCALE_UP_FRAMES;
+	}
+}
+
+// Times the GL work of the frame on the GPU. A slot whose query from
+// RENDER_GPU_TIMERS frames ago is still pending skips this frame instead of waiting
+void ModuleRender::BeginGpuTimer()
+{
+	gpu_timer_active = false;
+	if (!dynamic_resolution || gpu_timers[0] == 0)
+		return;
+
+	gpu_timer_slot = (gpu_timer_slot + 1) % RENDER_GPU_TIMERS;
+	uint slot = gpu_timer_slot;
+
+	double seconds;
+	if (gpu_timer_pending[slot] && rlGetGpuTimerResult(gpu_timers[slot], &seconds))
+	{
+		gpu_time = (float)seconds;
+		gpu_timer_pending[slot] = false;
+	}
+
+	if (!gpu_timer_pending[slot])
+	{
+		rlBeginGpuTimer(gpu_timers[slot]);
+		gpu_timer_pending[slot] = true;
+		gpu_timer_active = true;
+	}
+}
+
+// Called before EndDrawing() presents, so neither side includes the swap or
+// vsync wait. The CPU span is this frame's, the GPU time the newest finished
+// query: the GPU runs behind and is never waited for. The slower side bounds
+// the frame
+void ModuleRender::MeasureWorkTime()
+{
+	if (!dynamic_resolution)
+		return;
+
+	if (gpu_timer_active)
+	{
+		rlDrawRenderBatchActive();
+		rlEndGpuTimer();
+	}
+
+	// Oldest first, the newest finished query wins
+	for (int i = 1; i < RENDER_GPU_TIMERS; ++i)
+	{
+		uint slot = (gpu_timer_slot + i) % RENDER_GPU_TIMERS;
+
+		double seconds;
+		if (gpu_timer_pending[slot] && rlGetGpuTimerResult(gpu_timers[slot], &seconds))
+		{
+			gpu_time = (float)seconds;
+			gpu_timer_pending[slot] = false;
+		}
+	}
+
+	float cpu_time = (float)(GetTime() - App->GetFrameStart());
+	work_time = MAX(cpu_time, gpu_time);
+}
+
+void ModuleRender::BeginWorldPass()
+{
+	if (!dynamic_resolution)
+		return;
+
+	BeginTextureMode(world_target);
+	ClearBackground(background);
+
+	// Projection keeps the native screen size, only the viewport shrinks
+	rlViewport(0, 0, (int)(SCREEN_WIDTH * render_scale), (int)(SCREEN_HEIGHT * render_scale));
+
+	world_pass = true;
+}
+
+void ModuleRender::EndWorldPass()
+{
+	FlushBatches();
+	EndTextureMode();
+
+	world_pass = false;
+
+	float width = (float)(int)(SCREEN_WIDTH * render_scale);
+	float height = (float)(int)(SCREEN_HEIGHT * render_scale);
+
+	// Render textures are upside down, the used area sits at the bottom of the target
+	Rectangle source = { 0.0f, 0.0f, width, -height };
+	Rectangle dest = { 0.0f, 0.0f, (float)SCREEN_WIDTH, (float)SCREEN_HEIGHT };
+	::DrawTexturePro(world_target.texture, source, dest, Vector2{ 0.0f, 0.0f }, 0.0f, WHITE);
+}
+
+// Retained UI ----------------------------------------------------------------
+
+// Redraws the dirty areas of the cached UI target and draws it over the world
+void ModuleRender::ComposeUI()
+{
+	ui_composed = true;
+	stats.ui_redrawn = 0;
+
+	if (ui_target.id == 0)
+		return;
+
+	const std::vector<Rectangle>& dirty = ui_layer.CollectDirty();
+	const std::vector<int>& order = ui_layer.GetOrder();
+
+	stats.ui_widgets = ui_layer.GetWidgetCount();
+
+	if (!dirty.empty())
+	{
+		BeginTextureMode(ui_target);
+
+		// Keep a correct alpha channel in the target: color is stored premultiplied
+		rlSetBlendFactorsSeparate(RL_SRC_ALPHA, RL_ONE_MINUS_SRC_ALPHA, RL_ONE, RL_ONE_MINUS_SRC_ALPHA, RL_FUNC_ADD, RL_FUNC_ADD);
+		BeginBlendMode(BLEND_CUSTOM_SEPARATE);
+
+		for (const Rectangle& rect : dirty)
+		{
+			int x = (int)floorf(rect.x);
+			int y = (int)floorf(rect.y);
+			int w = (int)ceilf(rect.x + rect.width) - x;
+			int h = (int)ceilf(rect.y + rect.height) - y;
+
+			BeginScissorMode(x, y, w, h);
+			ClearBackground(BLANK);
+
+			for (int index : order)
+			{
+				const UIWidget& widget = ui_layer.GetWidget(index);
+
+				if (!CheckCollisionRecs(widget.bounds, rect))
+					continue;
+
+				for (const RenderCommand& retained : widget.commands)
+				{
+					RenderCommand command = retained;
+
+					if (command.type == RENDER_TEXT)
+					{
+						const UIWidgetText& text = widget.texts[command.payload];
+						command.payload = (uint)text_cache.GetRun(text.font, text.text.c_str(), text.size, text.spacing);
+					}
+
+					if (command.type != RENDER_TEXTURE && command.type != RENDER_TEXT && command.type != RENDER_LINE)
+						FlushBatches();
+
+					Submit(command);
+				}
+
+				stats.ui_redrawn++;
+			}
+
+			FlushBatches();
+			EndScissorMode();
+		}
+
+		EndBlendMode();
+		EndTextureMode();
+	}
+
+	ui_layer.EndFrame();
+
+	// Nothing retained: the target is fully cleared, skip the full screen quad
+	if (stats.ui_widgets == 0)
+		return;
+
+	BeginBlendMode(BLEND_ALPHA_PREMULTIPLY);
+
+	Rectangle source = { 0.0f, 0.0f, (float)SCREEN_WIDTH, -(float)SCREEN_HEIGHT };
+	Rectangle dest = { 0.0f, 0.0f, (float)SCREEN_WIDTH, (float)SCREEN_HEIGHT };
+	::DrawTexturePro(ui_target.texture, source, dest, Vector2{ 0.0f, 0.0f }, 0.0f, WHITE);
+
+	EndBlendMode();
+}
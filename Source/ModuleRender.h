@@ -1,8 +1,39 @@
 #pragma once
 #include "Module.h"
 #include "Globals.h"
+#include "TextureAtlas.h"
+#include "TextCache.h"
+#include "UILayer.h"
+
+#include "rlgl.h"
 
 #include <limits.h>
+#include <vector>
+
+// Dynamic resolution: the world layers are drawn into an offscreen target scaled
+// between these bounds depending on the measured work time, UI stays native.
+// Work time runs from PreUpdate until the GPU is done with the frame, the
+// vsync wait is left out, so the load thresholds are fractions of the budget
+#define RENDER_TARGET_FRAME_TIME	(1.0f / 60.0f)
+#define RENDER_SCALE_DOWN_LOAD		0.9f	// lower when the work takes more of the budget
+#define RENDER_SCALE_UP_LOAD		0.6f	// raise below this, one step up costs up to 1.44x the pixels
+#define RENDER_SCALE_MIN			0.5f
+#define RENDER_SCALE_MAX			1.0f
+#define RENDER_SCALE_STEP			0.1f
+#define RENDER_SCALE_DOWN_FRAMES	30		// frames to wait after a change before lowering again
+#define RENDER_SCALE_UP_FRAMES		120		// frames of headroom needed before raising
+#define RENDER_GPU_TIMERS			3		// GPU time queries in flight, read back frames later
+
+struct RenderStats
+{
+	uint commands = 0;
+	uint culled = 0;
+	uint texture_switches = 0;
+	uint text_runs = 0;			// cached text runs alive
+	uint text_built = 0;		// text runs laid out this frame
+	uint ui_widgets = 0;		// retained widgets alive
+	uint ui_redrawn = 0;		// widget replays into the cached UI target this frame
+};
 
 class ModuleRender : public Module
 {
@@ -11,14 +42,53 @@ public:
 	~ModuleRender();
 
 	bool Init();
+	bool Start();
 	update_status PreUpdate();
 	update_status Update();
 	update_status PostUpdate();
 	bool CleanUp();
 
     void SetBackgroundColor(Color color);
-	bool Draw(Texture2D texture, int x, int y, const Rectangle* section = NULL, double angle = 0, int pivot_x = 0, int pivot_y = 0, float scale = 0) const;
-    bool DrawText(const char* text, int x, int y, Font font, int spacing, Color tint) const;
+	bool Draw(Texture2D texture, int x, int y, const Rectangle* section = NULL, double angle = 0, int pivot_x = 0, int pivot_y = 0, float scale = 0, RenderLayer layer = LAYER_WORLD, Color tint = WHITE);
+    bool DrawText(const char* text, int x, int y, Font font, int spacing, Color tint);
+
+	// Atlas sprites: load them before Start(), draw them with the returned handle
+	int LoadSprite(const char* path);
+	Rectangle GetSpriteSection(int sprite) const;
+	bool DrawSprite(int sprite, int x, int y, double angle = 0, int pivot_x = 0, int pivot_y = 0, float scale = 0, RenderLayer layer = LAYER_WORLD, Color tint = WHITE);
+
+	// Queued versions of the raylib calls, nothing reaches rlgl until PostUpdate()
+	// NOTE: Coordinates are in screen space, world callers add the camera themselves
+	void DrawText(const char* text, int x, int y, int font_size, Color color, RenderLayer layer = LAYER_UI);
+	void DrawTextEx(Font font, const char* text, Vector2 position, float font_size, float spacing, Color tint, RenderLayer layer = LAYER_UI);
+	void DrawTexturePro(Texture2D texture, Rectangle source, Rectangle dest, Vector2 origin, float rotation, Color tint, RenderLayer layer = LAYER_UI);
+	void DrawLine(int start_x, int start_y, int end_x, int end_y, Color color, RenderLayer layer = LAYER_UI);
+	void DrawLineV(Vector2 start, Vector2 end, Color color, RenderLayer layer = LAYER_UI);
+	void DrawRectangle(int x, int y, int width, int height, Color color, RenderLayer layer = LAYER_UI);
+	void DrawRectangleRec(Rectangle rec, Color color, RenderLayer layer = LAYER_UI);
+	void DrawRectanglePro(Rectangle rec, Vector2 origin, float rotation, Color color, RenderLayer layer = LAYER_UI);
+	void DrawRectangleLines(int x, int y, int width, int height, Color color, RenderLayer layer = LAYER_UI);
+	void DrawRectangleLinesEx(Rectangle rec, float thick, Color color, RenderLayer layer = LAYER_UI);
+	void DrawCircle(int x, int y, float radius, Color color, RenderLayer layer = LAYER_UI);
+	void DrawCircleV(Vector2 center, float radius, Color color, RenderLayer layer = LAYER_UI);
+
+	// Cached MeasureText()/MeasureTextEx(), shares the layout with the queued text
+	int MeasureText(const char* text, int font_size);
+	Vector2 MeasureTextEx(Font font, const char* text, float font_size, float spacing);
+
+	// Pre-built line list, copied into the frame arena and kept as one command (never culled)
+	void DrawLines(const rlLine* lines, int count, RenderLayer layer = LAYER_DEBUG);
+
+	const RenderStats& GetStats() const;
+
+	// Retained UI: draw calls between a BeginWidget() that returned true and EndWidget()
+	// are kept by the widget and only replayed into the cached UI target when its area
+	// is dirty. When it returns false the widget is unchanged and nothing has to be drawn
+	bool BeginWidget(uint64 id, Rectangle bounds, uint64 state);
+	void EndWidget();
+
+	void SetDynamicResolution(bool enabled);
+	float GetRenderScale() const;
 
 	void DrawUIButton(int x, int y, int w, int h, const char* text, bool hover);
 
@@ -27,4 +97,69 @@ public:
 	Color background;
     Rectangle camera;
 	Font fuente;
-};
\ No newline at end of file
+
+private:
+
+	struct LineRun
+	{
+		uint offset;
+		uint count;
+	};
+
+	RenderCommand& Push(RenderCommandType type, RenderLayer layer, Color tint);
+	void SortQueue();
+	bool IsCulled(const RenderCommand& command) const;
+	void Submit(const RenderCommand& command);
+	void BatchQuad(const RenderCommand& command);
+	void BatchLine(const RenderCommand& command);
+	void BatchText(const RenderCommand& command);
+	void FlushBatches();
+	void FlushQueue();
+	void UpdateRenderScale();
+	void BeginGpuTimer();
+	void MeasureWorkTime();
+	void BeginWorldPass();
+	void EndWorldPass();
+	void ComposeUI();
+
+	TextureAtlas atlas;
+	TextCache text_cache;
+	UILayer ui_layer;
+
+	// Per-frame arena, cleared after every flush but never shrunk
+	std::vector<RenderCommand> commands;
+	std::vector<LineRun> line_runs;
+	std::vector<rlLine> line_arena;
+
+	std::vector<uint> sort_keys;
+	std::vector<uint> sort_order;
+	std::vector<uint> sort_keys_tmp;
+	std::vector<uint> sort_order_tmp;
+
+	// Consecutive sprites and lines go to rlgl in bulk
+	std::vector<rlQuad> quad_batch;
+	std::vector<rlLine> line_batch;
+	uint quad_texture = 0;
+
+	RenderStats stats;
+
+	// Offscreen world pass, allocated at native size and drawn into a scaled viewport
+	RenderTexture2D world_target = { 0 };
+	bool dynamic_resolution = true;
+	bool world_pass = false;
+	float render_scale = RENDER_SCALE_MAX;
+	float work_time = 0.0f;
+	float work_time_avg = 0.0f;
+	int scale_cooldown = 0;
+
+	// The GPU side of the work time, never waited for
+	uint gpu_timers[RENDER_GPU_TIMERS] = { 0 };
+	bool gpu_timer_pending[RENDER_GPU_TIMERS] = { false };
+	uint gpu_timer_slot = 0;
+	bool gpu_timer_active = false;
+	float gpu_time = 0.0f;
+
+	// Cached UI layer, redrawn only where widgets changed
+	RenderTexture2D ui_target = { 0 };
+	bool ui_composed = false;
+};
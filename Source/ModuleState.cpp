@@ -102,6 +102,9 @@ void ModuleState::ProcessStateChange()
 	currentState = nextState;
 	nextState = GameState::NONE;
 
+	// New screen: stay at full rate while it settles
+	App->RequestFrame();
+
 	// Enter new
 	switch (currentState)
 	{
@@ -122,7 +125,7 @@ void ModuleState::OnEnterMenu()
 
 	if (!menuMusicPlaying)
 	{
-		App->audio->PlayMusic("Assets/Audio/SFX/menuSong.wav", 0.0f, true);
+		App->audio->PlayMusic("Assets/Audio/SFX/menuSong.wav");
 		menuMusicPlaying = true;
 	}
 	endSongPlayed = false;
@@ -169,7 +172,7 @@ void ModuleState::OnEnterResults()
 	LOG("STATE ? RESULTS");
 	if (!endSongPlayed)
 	{
-		App->audio->PlayMusic("Assets/Audio/SFX/endSong.wav", 0.0f, false);
+		App->audio->PlayMusic("Assets/Audio/SFX/endSong.wav", DEFAULT_MUSIC_FADE_TIME, false);
 		endSongPlayed = true;
 	}
 	App->scene_intro->CreateMockUpCar();
@@ -180,6 +183,7 @@ void ModuleState::OnEnterResults()
 void ModuleState::OnExitResults()
 {
 	//printf("EXIT RESULTS\n");
+	App->scene_intro->StopReplayViewer();
 	App->scene_intro->DestroyMockUpCar();
 	App->scene_intro->onResults = false;
 }
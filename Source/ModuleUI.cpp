@@ -6,8 +6,10 @@
 #include "ModuleState.h"
 #include "ModuleGame.h"
 #include "ModuleAudio.h"
+#include "ModulePhysics.h"
 
 #include <math.h>
+#include <string.h>
 #include <string>
 #include <algorithm>
 
@@ -20,7 +22,7 @@ static float Clamp01(float v)
 	return v;
 }
 
-static float Slider01(Rectangle bar, float value01, bool& dragging)
+static float Slider01(ModuleRender* render, Rectangle bar, float value01, bool& dragging)
 {
 	Vector2 mouse = { (float)GetMouseX(), (float)GetMouseY() };
 	bool hovered = CheckCollisionPointRec(mouse, bar);
@@ -37,21 +39,68 @@ static float Slider01(Rectangle bar, float value01, bool& dragging)
 	if (dragging && IsMouseButtonReleased(MOUSE_LEFT_BUTTON))
 		dragging = false;
 
-	DrawRectangleRec(bar, Color{ 70, 70, 70, 255 });
-	DrawRectangleLines((int)bar.x, (int)bar.y, (int)bar.width, (int)bar.height, BLACK);
+	// Bounds include the handle, it sticks out of the bar
+	Rectangle bounds = { bar.x - 6.0f, bar.y - 4.0f, bar.width + 12.0f, bar.height + 8.0f };
+	uint32 valueBits;
+	memcpy(&valueBits, &value01, sizeof(valueBits));
+
+	if (!render->BeginWidget(UILayer::Hash("slider", bar), bounds, valueBits))
+		return value01;
+
+	render->DrawRectangleRec(bar, Color{ 70, 70, 70, 255 });
+	render->DrawRectangleLines((int)bar.x, (int)bar.y, (int)bar.width, (int)bar.height, BLACK);
 
 	Rectangle fill = bar;
 	fill.width = bar.width * value01;
-	DrawRectangleRec(fill, Color{ 120, 120, 120, 255 });
+	render->DrawRectangleRec(fill, Color{ 120, 120, 120, 255 });
 
 	float handleX = roundf(bar.x + bar.width * value01);
 	Rectangle handle = { handleX - 6.0f, bar.y - 4.0f, 12.0f, bar.height + 8.0f };
-	DrawRectangleRec(handle, Color{ 200, 200, 200, 255 });
-	DrawRectangleLines((int)handle.x, (int)handle.y, (int)handle.width, (int)handle.height, BLACK);
+	render->DrawRectangleRec(handle, Color{ 200, 200, 200, 255 });
+	render->DrawRectangleLines((int)handle.x, (int)handle.y, (int)handle.width, (int)handle.height, BLACK);
+
+	render->EndWidget();
 
 	return value01;
 }
 
+// Thumbnails are cached next to each map, the full map is only decoded when
+// the thumbnail is missing or older than the map itself
+static Texture2D LoadMapThumbnail(int mapId)
+{
+	const char* mapPath = TextFormat("Assets/Map%d/Map.png", mapId);
+	std::string thumbPath = TextFormat("Assets/Map%d/" MAP_THUMB_FILE, mapId);
+
+	Texture2D thumb = { 0 };
+
+	if (FileExists(thumbPath.c_str()) && GetFileModTime(thumbPath.c_str()) >= GetFileModTime(mapPath))
+		thumb = LoadTexture(thumbPath.c_str());
+
+	if (thumb.id == 0)
+	{
+		LOG("Baking map thumbnail %s", thumbPath.c_str());
+
+		Image image = LoadImage(mapPath);
+		if (image.data == NULL)
+		{
+			LOG("Cannot load map image: %s", mapPath);
+			return thumb;
+		}
+
+		// stb resize filters the whole source area, unlike sampling the big texture at draw time
+		ImageResize(&image, MAP_THUMB_WIDTH, MAP_THUMB_HEIGHT);
+
+		if (!ExportImage(image, thumbPath.c_str()))
+			LOG("Cannot write map thumbnail %s, it will be baked again next run", thumbPath.c_str());
+
+		thumb = LoadTextureFromImage(image);
+		UnloadImage(image);
+	}
+
+	SetTextureFilter(thumb, TEXTURE_FILTER_BILINEAR);
+	return thumb;
+}
+
 ModuleUI::ModuleUI(Application* app, bool start_enabled) : Module(app, start_enabled)
 {
 }
@@ -65,10 +114,8 @@ bool ModuleUI::Init()
 	LOG("Initializing UI module");
 
 	pressFx = App->audio->LoadFx("Assets/Audio/SFX/pressSound.wav");
-	mapThumbs[0] = LoadTexture("Assets/Map1/Map.png");
-	mapThumbs[1] = LoadTexture("Assets/Map2/Map.png");
-	mapThumbs[2] = LoadTexture("Assets/Map3/Map.png");
-	mapThumbs[3] = LoadTexture("Assets/Map4/Map.png");
+	for (int i = 0; i < MAP_COUNT; ++i)
+		mapThumbs[i] = LoadMapThumbnail(i + 1);
 
 	return true;
 }
@@ -116,7 +163,7 @@ update_status ModuleUI::PostUpdate()
 
 bool ModuleUI::CleanUp()
 {
-	for (int i = 0; i < 4; ++i) {
+	for (int i = 0; i < MAP_COUNT; ++i) {
 		UnloadTexture(mapThumbs[i]);
 	}
 	return true;
@@ -134,11 +181,18 @@ bool ModuleUI::Button(int x, int y, int w, int h, const char* text)
 	Color border = BLACK;
 	Color textCol = RAYWHITE;
 
-	DrawRectangleRec(rect, hover ? bgHover : bgNormal);
-	DrawRectangleLines((int)rect.x, (int)rect.y, (int)rect.width, (int)rect.height, border);
+	bool clicked = hover && IsMouseButtonPressed(MOUSE_LEFT_BUTTON);
+	if (clicked)
+		App->audio->PlayFx(pressFx);
+
+	if (!App->renderer->BeginWidget(UILayer::Hash(text ? text : "", rect), rect, hover ? 1 : 0))
+		return clicked;
+
+	App->renderer->DrawRectangleRec(rect, hover ? bgHover : bgNormal);
+	App->renderer->DrawRectangleLines((int)rect.x, (int)rect.y, (int)rect.width, (int)rect.height, border);
 
 	if (hover)
-		DrawRectangleLinesEx(rect, 2.0f, YELLOW);
+		App->renderer->DrawRectangleLinesEx(rect, 2.0f, YELLOW);
 
 	if (text && text[0] != '\0')
 	{
@@ -149,21 +203,17 @@ bool ModuleUI::Button(int x, int y, int w, int h, const char* text)
 		if (fontSize > 28.0f) fontSize = 28.0f;
 
 		const float spacing = 1.0f;
-		Vector2 textSize = MeasureTextEx(font, text, fontSize, spacing);
+		Vector2 textSize = App->renderer->MeasureTextEx(font, text, fontSize, spacing);
 
 		float textX = roundf(rect.x + (rect.width - textSize.x) * 0.5f);
 		float textY = roundf(rect.y + (rect.height - textSize.y) * 0.5f);
 
-		DrawTextEx(font, text, Vector2{ textX, textY }, fontSize, spacing, textCol);
+		App->renderer->DrawTextEx(font, text, Vector2{ textX, textY }, fontSize, spacing, textCol);
 	}
 
-	if (hover && IsMouseButtonPressed(MOUSE_LEFT_BUTTON))
-	{
-		App->audio->PlayFx(pressFx);
-		return true;
-	}
+	App->renderer->EndWidget();
 
-	return false;
+	return clicked;
 }
 
 void ModuleUI::UpdateMainMenu()
@@ -175,7 +225,12 @@ void ModuleUI::UpdateMainMenu()
 	int x = SCREEN_WIDTH / 2 - buttonW / 2;
 	int centerY = SCREEN_HEIGHT / 2;
 
-	DrawText("Physics GP",SCREEN_WIDTH/2 - 200, 100, 80, BLACK);
+	Rectangle title = { (float)(SCREEN_WIDTH / 2 - 200), 100.0f, (float)App->renderer->MeasureText("Physics GP", 80), 80.0f };
+	if (App->renderer->BeginWidget(UILayer::Hash("main_title", title), title, 0))
+	{
+		App->renderer->DrawText("Physics GP",SCREEN_WIDTH/2 - 200, 100, 80, BLACK);
+		App->renderer->EndWidget();
+	}
 
 	if (Button(x, centerY - buttonH - spacing / 2, buttonW, buttonH, "JUGAR"))
 		App->state->ChangeState(GameState::MENU_PLAY);
@@ -188,11 +243,14 @@ void ModuleUI::UpdatePlayMenu()
 {
 	int centerX = SCREEN_WIDTH / 2;
 
-	DrawText(
-		"SELECCIONA MAPA",
-		centerX - MeasureText("SELECCIONA MAPA", 24) / 2,
-		100, 24, BLACK
-	);
+	int titleW = App->renderer->MeasureText("SELECCIONA MAPA", 24);
+	Rectangle title = { (float)(centerX - titleW / 2), 100.0f, (float)titleW, 24.0f };
+
+	if (App->renderer->BeginWidget(UILayer::Hash("play_title", title), title, 0))
+	{
+		App->renderer->DrawText("SELECCIONA MAPA", centerX - titleW / 2, 100, 24, BLACK);
+		App->renderer->EndWidget();
+	}
 
 	const int buttonW = 220;
 	const int buttonH = 140;
@@ -202,8 +260,6 @@ void ModuleUI::UpdatePlayMenu()
 	int startX = centerX - (buttonW * 2 + spacingX) / 2;
 	int startY = 160;
 
-	Vector2 mouse = { (float)GetMouseX(), (float)GetMouseY() };
-
 	int mapId = 1;
 
 	for (int row = 0; row < 2; ++row)
@@ -215,41 +271,13 @@ void ModuleUI::UpdatePlayMenu()
 			int x = startX + col * (buttonW + spacingX);
 			int y = startY + row * (buttonH + spacingY);
 
-			Rectangle rect = {
-				(float)x,
-				(float)y,
-				(float)buttonW,
-				(float)buttonH
-			};
-
-			bool hover = CheckCollisionPointRec(mouse, rect);
-
-			// Botón imagen
-			if (ImageButton(x, y, buttonW, buttonH, mapThumbs[index]))
+			// Botón imagen con su borde y el texto del mapa
+			if (ImageButton(x, y, buttonW, buttonH, mapThumbs[index], TextFormat("MAPA %d", mapId)))
 			{
 				App->state->mapId = mapId;
 				App->state->ChangeState(GameState::RACE);
 			}
 
-			// Borde amarillo en hover
-			if (hover)
-			{
-				DrawRectangleLinesEx(rect, 3, YELLOW);
-			}
-			else
-			{
-				DrawRectangleLinesEx(rect, 2, BLACK);
-			}
-
-			// Texto del mapa
-			DrawText(
-				TextFormat("MAPA %d", mapId),
-				x + 10,
-				y + buttonH - 24,
-				18,
-				BLACK
-			);
-
 			mapId++;
 		}
 	}
@@ -268,23 +296,30 @@ void ModuleUI::UpdateOptionsMenu()
 	const int panelX = SCREEN_WIDTH / 2 - panelW / 2;
 	const int panelY = SCREEN_HEIGHT / 2 - panelH / 2;
 
-	DrawRectangle(panelX, panelY, panelW, panelH, Color{ 0, 0, 0, 120 });
-	DrawRectangleLines(panelX, panelY, panelW, panelH, BLACK);
+	// Panel and static labels never change, they are recorded once
+	Rectangle panel = { (float)panelX, (float)panelY, (float)panelW, (float)panelH };
+	if (App->renderer->BeginWidget(UILayer::Hash("options_panel", panel), panel, 0))
+	{
+		App->renderer->DrawRectangle(panelX, panelY, panelW, panelH, Color{ 0, 0, 0, 120 });
+		App->renderer->DrawRectangleLines(panelX, panelY, panelW, panelH, BLACK);
+
+		App->renderer->DrawText("CONFIGURACION", panelX + 20, panelY + 20, 28, RAYWHITE);
+		App->renderer->DrawText("VOLUMEN SFX", panelX + 20, panelY + 80, 20, RAYWHITE);
+		App->renderer->DrawText("VOLUMEN MUSICA", panelX + 20, panelY + 210, 20, RAYWHITE);
 
-	DrawText("CONFIGURACION", panelX + 20, panelY + 20, 28, RAYWHITE);
+		App->renderer->EndWidget();
+	}
 
 	// SFX Volume
 	{
 		float sfx = App->audio->GetSfxVolume();
 
-		DrawText("VOLUMEN SFX", panelX + 20, panelY + 80, 20, RAYWHITE);
-
 		Rectangle bar = Rectangle{ (float)(panelX + 220), (float)(panelY + 82), 250.0f, 18.0f };
-		sfx = Slider01(bar, sfx, draggingSfx);
+		sfx = Slider01(App->renderer, bar, sfx, draggingSfx);
 		App->audio->SetSfxVolume(sfx);
 
 		int percent = (int)roundf(sfx * 100.0f);
-		DrawText(TextFormat("%d%%", percent), panelX + 480, panelY + 78, 20, RAYWHITE);
+		PercentLabel("sfx_percent", panelX + 480, panelY + 78, percent);
 	}
 
 	// Music Enabled Toggle
@@ -305,12 +340,12 @@ void ModuleUI::UpdateOptionsMenu()
 				// Menus use menuSong
 				if (st == GameState::MENU_MAIN || st == GameState::MENU_PLAY || st == GameState::MENU_OPTIONS)
 				{
-					App->audio->PlayMusic("Assets/Audio/SFX/menuSong.wav", 0.0f, true);
+					App->audio->PlayMusic("Assets/Audio/SFX/menuSong.wav");
 				}
 				// Results uses endSong
 				else if (st == GameState::RESULTS)
 				{
-					App->audio->PlayMusic("Assets/Audio/SFX/endSong.wav", 0.0f, false);
+					App->audio->PlayMusic("Assets/Audio/SFX/endSong.wav", DEFAULT_MUSIC_FADE_TIME, false);
 				}
 				// Race: keep silent (by design)
 			}
@@ -322,14 +357,12 @@ void ModuleUI::UpdateOptionsMenu()
 	{
 		float mv = App->audio->GetMusicVolume();
 
-		DrawText("VOLUMEN MUSICA", panelX + 20, panelY + 210, 20, RAYWHITE);
-
 		Rectangle bar = Rectangle{ (float)(panelX + 220), (float)(panelY + 212), 250.0f, 18.0f };
-		mv = Slider01(bar, mv, draggingMusic);
+		mv = Slider01(App->renderer, bar, mv, draggingMusic);
 		App->audio->SetMusicVolume(mv);
 
 		int percent = (int)roundf(mv * 100.0f);
-		DrawText(TextFormat("%d%%", percent), panelX + 480, panelY + 208, 20, RAYWHITE);
+		PercentLabel("music_percent", panelX + 480, panelY + 208, percent);
 	}
 
 	if (Button(panelX + panelW - 260, panelY + panelH - 76, 240, 56, "ATRAS"))
@@ -343,6 +376,7 @@ void ModuleUI::SyncLeaderboard()
 	if (leaderboardUI.size() != data.size())
 	{
 		leaderboardUI.clear();
+		rankLabels.clear();
 
 		for (int i = 0; i < (int)data.size(); ++i)
 		{
@@ -354,7 +388,10 @@ void ModuleUI::SyncLeaderboard()
 			entry.rank = i + 1;
 			entry.lastRank = -1;
 			entry.flashTimer = 0.0f;
+			snprintf(entry.label, sizeof(entry.label), "Coche %d", entry.carId);
 			leaderboardUI.push_back(entry);
+
+			rankLabels.push_back(std::to_string(i + 1));
 		}
 	}
 
@@ -390,7 +427,9 @@ void ModuleUI::UpdateLeaderboardAnimation()
 
 void ModuleUI::DrawLeaderboard()
 {
-	DrawText("POSICIONES", 20, 20, 20, BLACK);
+	// Row colors and positions make up the panel state, it is only redrawn while something moves or flashes
+	uint64 state = leaderboardUI.size();
+	float bottom = 50.0f + (float)leaderboardUI.size() * 24.0f;
 
 	for (int i = 0; i < (int)leaderboardUI.size(); ++i)
 	{
@@ -404,9 +443,29 @@ void ModuleUI::DrawLeaderboard()
 			e.flashTimer -= App->deltaTime;
 		}
 
-		DrawText(TextFormat("%d", i + 1), 20, 50 + i * 24, 18, BLACK);
-		DrawText(TextFormat("Coche %d", e.carId), 50, (int)e.y, 18, color);
+		e.color = color;
+		bottom = MAX(bottom, e.y + 24.0f);
+
+		state = UILayer::Combine(state, (uint64)e.carId);
+		state = UILayer::Combine(state, (uint64)(int)e.y);
+		state = UILayer::Combine(state, (uint64)ColorToInt(color));
+	}
+
+	Rectangle panel = { 0.0f, 0.0f, 200.0f, bottom };
+	if (!App->renderer->BeginWidget(UILayer::Hash("leaderboard", Rectangle{ 0.0f, 0.0f, 0.0f, 0.0f }), panel, state))
+		return;
+
+	App->renderer->DrawText("POSICIONES", 20, 20, 20, BLACK);
+
+	for (int i = 0; i < (int)leaderboardUI.size(); ++i)
+	{
+		const auto& e = leaderboardUI[i];
+
+		App->renderer->DrawText(rankLabels[i].c_str(), 20, 50 + i * 24, 18, BLACK);
+		App->renderer->DrawText(e.label, 50, (int)e.y, 18, e.color);
 	}
+
+	App->renderer->EndWidget();
 }
 
 void ModuleUI::DrawResultsScreen()
@@ -416,25 +475,96 @@ void ModuleUI::DrawResultsScreen()
 	const int panelX = SCREEN_WIDTH / 2 - panelW / 2;
 	const int panelY = SCREEN_HEIGHT / 2 - panelH / 2;
 
+	if (App->scene_intro->viewing_replay)
+	{
+		DrawReplayBar();
+		return;
+	}
+
+	// Results do not change while the screen is up, the panel is recorded once
+	const auto& results = App->scene_intro->results;
+	uint64 state = UILayer::Combine(results.finalLeaderboard.size(), results.lapTimes.size());
+	state = UILayer::Combine(state, (uint64)(results.totalTime * 1000.0));
+
+	Rectangle panel = { (float)panelX, (float)panelY, (float)panelW, (float)panelH };
+	if (App->renderer->BeginWidget(UILayer::Hash("results_panel", panel), panel, state))
+	{
+		DrawResultsPanel(panelX, panelY, panelW, panelH);
+		App->renderer->EndWidget();
+	}
+
+	// Botón volver al menú
+	bool hasReplay = !App->scene_intro->replay.IsEmpty();
+	int buttonX = hasReplay ? panelX + panelW / 2 - 250 : panelX + panelW / 2 - 120;
+
+	if (Button(buttonX, panelY + panelH - 76, 240, 56, "VOLVER AL MENU"))
+	{
+		App->state->ChangeState(GameState::MENU_MAIN);
+	}
+
+	if (hasReplay && Button(panelX + panelW / 2 + 10, panelY + panelH - 76, 240, 56, "VER REPETICION"))
+	{
+		App->scene_intro->StartReplayViewer();
+	}
+}
+
+void ModuleUI::DrawReplayBar()
+{
+	const int barW = 520;
+	const int barH = 64;
+	const int barX = SCREEN_WIDTH / 2 - barW / 2;
+	const int barY = SCREEN_HEIGHT - barH - 20;
+
+	const ModuleGame* game = App->scene_intro;
+	float length = (float)game->replay.GetLength();
+	float progress = (length > 0.0f) ? game->replay_tick / length : 0.0f;
+
+	// Redrawn when the shown tenth of a second changes
+	Rectangle bar = { (float)barX, (float)barY, (float)barW, (float)barH };
+	uint64 state = UILayer::Combine((uint64)(game->replay_tick / 6.0f), game->replay_paused ? 1 : 0);
+
+	if (App->renderer->BeginWidget(UILayer::Hash("replay_bar", bar), bar, state))
+	{
+		App->renderer->DrawRectangle(barX, barY, barW, barH, Color{ 0, 0, 0, 180 });
+		App->renderer->DrawRectangleLines(barX, barY, barW, barH, BLACK);
+
+		App->renderer->DrawText(TextFormat("%s %.1f / %.1f s", game->replay_paused ? "||" : ">", game->replay_tick / 60.0f, length / 60.0f),
+			barX + 16, barY + 12, 20, RAYWHITE);
+
+		const int trackW = barW - 180;
+		App->renderer->DrawRectangle(barX + 16, barY + 42, trackW, 8, Color{ 90, 90, 90, 255 });
+		App->renderer->DrawRectangle(barX + 16, barY + 42, (int)(trackW * progress), 8, YELLOW);
+
+		App->renderer->EndWidget();
+	}
+
+	if (Button(barX + barW - 150, barY + 10, 134, 44, "VOLVER"))
+	{
+		App->scene_intro->StopReplayViewer();
+	}
+}
+
+void ModuleUI::DrawResultsPanel(int panelX, int panelY, int panelW, int panelH)
+{
 	// Panel fondo
-	DrawRectangle(panelX, panelY, panelW, panelH, Color{ 0, 0, 0, 180 });
-	DrawRectangleLines(panelX, panelY, panelW, panelH, BLACK);
+	App->renderer->DrawRectangle(panelX, panelY, panelW, panelH, Color{ 0, 0, 0, 180 });
+	App->renderer->DrawRectangleLines(panelX, panelY, panelW, panelH, BLACK);
 
 	int x = panelX + 20;
 	int y = panelY + 20;
 
 	// Título
 	const char* title = "RACE RESULTS";
-	DrawText(title, panelX + panelW / 2 - MeasureText(title, 28) / 2, y, 28, RAYWHITE);
+	App->renderer->DrawText(title, panelX + panelW / 2 - App->renderer->MeasureText(title, 28) / 2, y, 28, RAYWHITE);
 	y += 50;
 
 	// Clasificación
-	DrawText("FINAL POSITIONS", x, y, 22, RAYWHITE);
+	App->renderer->DrawText("FINAL POSITIONS", x, y, 22, RAYWHITE);
 	y += 30;
 
 	for (int i = 0; i < (int)App->scene_intro->results.finalLeaderboard.size(); ++i)
 	{
-		DrawText(
+		App->renderer->DrawText(
 			TextFormat("%d. Car %d", i + 1, App->scene_intro->results.finalLeaderboard[i]),
 			x, y, 18, RAYWHITE
 		);
@@ -444,7 +574,7 @@ void ModuleUI::DrawResultsScreen()
 	y += 20;
 
 	// Tiempos de vuelta
-	DrawText("LAP TIMES (s)", x, y, 22, RAYWHITE);
+	App->renderer->DrawText("LAP TIMES (s)", x, y, 22, RAYWHITE);
 	y += 30;
 
 	const auto& lapTimes = App->scene_intro->results.lapTimes;
@@ -452,8 +582,8 @@ void ModuleUI::DrawResultsScreen()
 
 	for (int i = 0; i < lapTimes.size(); ++i)
 	{
-		DrawText(
-			TextFormat("Lap %d: %.2f", i + 1, lapTimes[i]),
+		App->renderer->DrawText(
+			TextFormat("Lap %d: %.3f", i + 1, lapTimes[i]),
 			x, y, 18, RAYWHITE
 		);
 		y += 22;
@@ -462,16 +592,10 @@ void ModuleUI::DrawResultsScreen()
 	y += 10;
 
 	// Tiempo total
-	DrawText(
-		TextFormat("TOTAL TIME: %.2f s", totalTime),
+	App->renderer->DrawText(
+		TextFormat("TOTAL TIME: %.3f s", totalTime),
 		x, y, 20, YELLOW
 	);
-
-	// Botón volver al menú
-	if (Button(panelX + panelW / 2 - 120, panelY + panelH - 76, 240, 56, "VOLVER AL MENU"))
-	{
-		App->state->ChangeState(GameState::MENU_MAIN);
-	}
 }
 
 void ModuleUI::DrawRaceTimer()
@@ -482,29 +606,82 @@ void ModuleUI::DrawRaceTimer()
 	int seconds = (int)time % 60;
 	int millis = (int)((time - (int)time) * 1000);
 
-	DrawText(TextFormat("%02d:%02d.%03d", minutes, seconds, millis),
-		SCREEN_WIDTH / 2 - 80, 20, 30, BLACK);
+	int total = (minutes * 60 + seconds) * 1000 + millis;
+	if (total != raceTimerMillis)
+	{
+		raceTimerMillis = total;
+		snprintf(raceTimerText, sizeof(raceTimerText), "%02d:%02d.%03d", minutes, seconds, millis);
+	}
+
+	App->renderer->DrawText(raceTimerText, SCREEN_WIDTH / 2 - 80, 20, 30, BLACK);
+
+	RaceSplit split = App->scene_intro->GetLastSplit();
+	double age = ModulePhysics::TicksToSeconds((double)App->scene_intro->race_tick - split.tick);
+
+	if (split.checkpoint < 0 || age > RACE_SPLIT_SHOW_SECONDS)
+		return;
+
+	if (split.tick != raceSplitTick)
+	{
+		raceSplitTick = split.tick;
+
+		if (split.has_delta)
+			snprintf(raceSplitText, sizeof(raceSplitText), "CP %d  %.3f  %+.3f", split.checkpoint + 1, split.time, split.delta);
+		else
+			snprintf(raceSplitText, sizeof(raceSplitText), "CP %d  %.3f", split.checkpoint + 1, split.time);
+	}
+
+	Color color = !split.has_delta ? BLACK : (split.delta > 0.0) ? RED : DARKGREEN;
+	App->renderer->DrawText(raceSplitText, SCREEN_WIDTH / 2 - 80, 55, 20, color);
+}
+
+void ModuleUI::PercentLabel(const char* name, int x, int y, int percent)
+{
+	// Wide enough for "100%" at size 20
+	Rectangle rect = { (float)x, (float)y, 60.0f, 20.0f };
+
+	if (App->renderer->BeginWidget(UILayer::Hash(name, rect), rect, (uint64)percent))
+	{
+		App->renderer->DrawText(TextFormat("%d%%", percent), x, y, 20, RAYWHITE);
+		App->renderer->EndWidget();
+	}
 }
 
-bool ModuleUI::ImageButton(int x, int y, int w, int h, Texture2D& tex)
+bool ModuleUI::ImageButton(int x, int y, int w, int h, Texture2D& tex, const char* label)
 {
 	Vector2 mouse = { (float)GetMouseX(), (float)GetMouseY() };
 	Rectangle rect = { (float)x, (float)y, (float)w, (float)h };
 
 	bool hover = CheckCollisionPointRec(mouse, rect);
+	bool clicked = hover && IsMouseButtonPressed(MOUSE_LEFT_BUTTON);
+
+	uint64 state = UILayer::Combine(tex.id, hover ? 1 : 0);
+	if (!App->renderer->BeginWidget(UILayer::Hash(label ? label : "image", rect), rect, state))
+		return clicked;
 
 	// Fondo
-	DrawRectangle(x, y, w, h, hover ? LIGHTGRAY : RAYWHITE);
+	App->renderer->DrawRectangle(x, y, w, h, hover ? LIGHTGRAY : RAYWHITE);
 
 	// Imagen centrada
 	Rectangle src = { 0, 0, (float)tex.width, (float)tex.height };
 	Rectangle dst = { (float)x, (float)y, (float)w, (float)h };
-	DrawTexturePro(tex, src, dst, { 0,0 }, 0, WHITE);
+	App->renderer->DrawTexturePro(tex, src, dst, { 0,0 }, 0, WHITE);
 
 	// Borde
-	DrawRectangleLines(x, y, w, h, BLACK);
+	App->renderer->DrawRectangleLines(x, y, w, h, BLACK);
+
+	// Borde amarillo en hover
+	if (hover)
+		App->renderer->DrawRectangleLinesEx(rect, 3, YELLOW);
+	else
+		App->renderer->DrawRectangleLinesEx(rect, 2, BLACK);
+
+	if (label != NULL)
+		App->renderer->DrawText(label, x + 10, y + h - 24, 18, BLACK);
+
+	App->renderer->EndWidget();
 
-	return hover && IsMouseButtonPressed(MOUSE_LEFT_BUTTON);
+	return clicked;
 }
 
 void ModuleUI::UpdateRaceUI()
@@ -3,6 +3,12 @@
 #include "Module.h"
 #include "Globals.h"
 #include <vector>
+#include <string>
+
+#define MAP_COUNT 4
+#define MAP_THUMB_WIDTH 220		// same size as the play menu buttons
+#define MAP_THUMB_HEIGHT 140
+#define MAP_THUMB_FILE "Thumb.png"
 
 struct LeaderboardEntryUI
 {
@@ -13,6 +19,8 @@ struct LeaderboardEntryUI
 	int rank = -1;
 	int lastRank = -1;
 	float flashTimer = 0.0f;
+	char label[16] = { 0 };		// formatted once when the entry is created
+	Color color = BLACK;
 };
 
 class ModuleUI : public Module
@@ -39,15 +47,27 @@ public:
 	void DrawLeaderboard();
 
 	void DrawResultsScreen();
+	void DrawResultsPanel(int panelX, int panelY, int panelW, int panelH);
+	void DrawReplayBar();
 	void DrawRaceTimer();
 
-	bool ImageButton(int x, int y, int w, int h, Texture2D& tex);
+	bool ImageButton(int x, int y, int w, int h, Texture2D& tex, const char* label = NULL);
+	void PercentLabel(const char* name, int x, int y, int percent);
 
 private:
 	std::vector<LeaderboardEntryUI> leaderboardUI;
+	std::vector<std::string> rankLabels;
+
+	// Race timer text is only formatted again when the shown millisecond changes
+	int raceTimerMillis = -1;
+	char raceTimerText[16] = { 0 };
+
+	// Same for the checkpoint split under it, formatted once per crossing
+	double raceSplitTick = -1.0;
+	char raceSplitText[48] = { 0 };
 
 	unsigned int pressFx = 0;
-	Texture2D mapThumbs[4];
+	Texture2D mapThumbs[MAP_COUNT];
 	bool draggingSfx = false;
 	bool draggingMusic = false;
 };
@@ -21,7 +21,6 @@ bool ModuleWindow::Init()
 	bool fullscreen = WIN_FULLSCREEN;
 	bool borderless = WIN_BORDERLESS;
 	bool resizable = WIN_RESIZABLE;
-	bool vsync = VSYNC;
 
 	width = SCREEN_WIDTH;
 	height = SCREEN_HEIGHT;
@@ -37,6 +37,9 @@ public:
     // Gather relevant win events
     bool GetWindowEvent(WindowEvent ev);
 
+	// Set before Init(), the --perf harness runs without it
+	bool vsync = VSYNC;
+
 private:
 	uint width;
 	uint height;
@@ -0,0 +1,385 @@
+#include "Globals.h"
+#include "MusicPlayer.h"
+
+#include <string.h>
+#include <chrono>
+
+MusicPlayer* MusicPlayer::active = NULL;
+
+MusicPlayer::MusicPlayer()
+{
+	stream = AudioStream{ 0 };
+}
+
+MusicPlayer::~MusicPlayer()
+{
+}
+
+bool MusicPlayer::Init(const AudioBank* audio_bank)
+{
+	bank = audio_bank;
+
+	for (int i = 0; i < MUSIC_DECKS; ++i)
+		decks[i].ring.assign(MUSIC_RING_FRAMES * 2, 0.0f);
+
+	stream = LoadAudioStream(MUSIC_SAMPLE_RATE, 32, 2);
+
+	if (!IsAudioStreamReady(stream))
+	{
+		LOG("Cannot create music audio stream");
+		return false;
+	}
+
+	// raylib callbacks carry no user pointer, there is only one player
+	active = this;
+	SetAudioStreamCallback(stream, StreamCallback);
+	PlayAudioStream(stream);
+
+	running = true;
+	worker = std::thread(&MusicPlayer::WorkerLoop, this);
+
+	return true;
+}
+
+void MusicPlayer::CleanUp()
+{
+	// The mixer stops reading the decks before the worker frees them
+	if (IsAudioStreamReady(stream))
+	{
+		StopAudioStream(stream);
+		UnloadAudioStream(stream);
+		stream = AudioStream{ 0 };
+	}
+	active = NULL;
+
+	if (worker.joinable())
+	{
+		running = false;
+		worker.join();
+	}
+
+	for (int i = 0; i < MUSIC_DECKS; ++i)
+		ReleaseDeck(decks[i]);
+}
+
+bool MusicPlayer::Play(const char* path, float fade_time, bool loop)
+{
+	if (!running)
+		return false;
+
+	bool found = (bank != NULL && bank->Contains(path)) || FileExists(path);
+
+	if (strlen(path) >= MUSIC_PATH_LENGTH || !found)
+	{
+		LOG("Cannot load music: %s", path);
+		return false;
+	}
+
+	MusicRequest request;
+	request.type = MUSIC_REQUEST_PLAY;
+	strcpy(request.path, path);
+	request.fade_time = fade_time;
+	request.loop = loop;
+
+	return requests.Push(request);
+}
+
+void MusicPlayer::Stop(float fade_time)
+{
+	if (!running)
+		return;
+
+	MusicRequest request;
+	request.type = MUSIC_REQUEST_STOP;
+	request.fade_time = fade_time;
+
+	requests.Push(request);
+}
+
+void MusicPlayer::SetVolume(float value)
+{
+	volume = value;
+}
+
+// Worker thread ------------------------------------------------------
+
+void MusicPlayer::WorkerLoop()
+{
+	while (running)
+	{
+		for (int i = 0; i < MUSIC_DECKS; ++i)
+		{
+			if (decks[i].state.load(std::memory_order_acquire) == MUSIC_DECK_DONE)
+				ReleaseDeck(decks[i]);
+		}
+
+		if (!has_pending)
+			has_pending = requests.Pop(pending);
+
+		if (has_pending)
+		{
+			if (pending.type == MUSIC_REQUEST_STOP)
+			{
+				FadeOutDecks(pending.fade_time);
+				has_pending = false;
+			}
+			else
+			{
+				// With both decks busy the request waits for the fading one to finish
+				for (int i = 0; i < MUSIC_DECKS; ++i)
+				{
+					if (decks[i].state.load(std::memory_order_acquire) == MUSIC_DECK_IDLE)
+					{
+						StartDeck(pending);
+						has_pending = false;
+						break;
+					}
+				}
+			}
+		}
+
+		for (int i = 0; i < MUSIC_DECKS; ++i)
+		{
+			int state = decks[i].state.load(std::memory_order_acquire);
+			if (state == MUSIC_DECK_PLAYING || state == MUSIC_DECK_FADING)
+				Feed(decks[i]);
+		}
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(MUSIC_FEED_INTERVAL_MS));
+	}
+}
+
+// The first chunks of the new track are decoded while the old one keeps
+// playing, the crossfade starts as soon as the ring is full
+void MusicPlayer::StartDeck(const MusicRequest& request)
+{
+	MusicDeck* deck = NULL;
+	for (int i = 0; i < MUSIC_DECKS && deck == NULL; ++i)
+	{
+		if (decks[i].state.load(std::memory_order_acquire) == MUSIC_DECK_IDLE)
+			deck = &decks[i];
+	}
+
+	if (deck == NULL)
+		return;
+
+	AudioDecoder decoder = (bank != NULL && bank->Contains(request.path)) ? bank->LoadDecoder(request.path) : LoadAudioDecoder(request.path);
+	if (!IsAudioDecoderReady(decoder) || decoder.channels > MUSIC_MAX_CHANNELS)
+	{
+		LOG("Cannot load music: %s", request.path);
+		UnloadAudioDecoder(decoder);
+		return;
+	}
+
+	deck->decoder = decoder;
+	deck->decoded.resize(MUSIC_DECODE_FRAMES * decoder.channels);
+	deck->chunk.resize((MUSIC_DECODE_FRAMES + 1) * 2);
+	deck->chunk_frames = 0;
+	deck->chunk_pos = 0.0;
+	deck->step = (double)decoder.sampleRate / MUSIC_SAMPLE_RATE;
+	deck->source_ended = false;
+	deck->loop = request.loop;
+	deck->ended = false;
+	deck->write = 0;
+	deck->read = 0;
+	deck->fade_time = request.fade_time;
+
+	Feed(*deck);
+
+	FadeOutDecks(request.fade_time);
+	deck->state.store(MUSIC_DECK_PLAYING, std::memory_order_release);
+
+	LOG("Successfully playing %s", request.path);
+}
+
+void MusicPlayer::FadeOutDecks(float fade_time)
+{
+	for (int i = 0; i < MUSIC_DECKS; ++i)
+	{
+		if (decks[i].state.load(std::memory_order_acquire) != MUSIC_DECK_PLAYING)
+			continue;
+
+		// The mixer may have just drained a finished track, then it stays done
+		int expected = MUSIC_DECK_PLAYING;
+		decks[i].fade_time = fade_time;
+		decks[i].state.compare_exchange_strong(expected, MUSIC_DECK_FADING, std::memory_order_acq_rel);
+	}
+}
+
+void MusicPlayer::Feed(MusicDeck& deck)
+{
+	if (deck.ended.load(std::memory_order_relaxed))
+		return;
+
+	uint write = deck.write.load(std::memory_order_relaxed);
+	uint space = MUSIC_RING_FRAMES - (write - deck.read.load(std::memory_order_acquire));
+
+	bool ended = false;
+
+	// Linear interpolation between chunk frames, exact copies when the rates match
+	while (space > 0)
+	{
+		uint frame = (uint)deck.chunk_pos;
+
+		if (frame + 1 >= deck.chunk_frames)
+		{
+			if (DecodeChunk(deck))
+				continue;
+
+			ended = true;
+			break;
+		}
+
+		float t = (float)(deck.chunk_pos - frame);
+		const float* a = &deck.chunk[frame * 2];
+		const float* b = a + 2;
+
+		uint index = (write & (MUSIC_RING_FRAMES - 1)) * 2;
+		deck.ring[index] = a[0] + (b[0] - a[0]) * t;
+		deck.ring[index + 1] = a[1] + (b[1] - a[1]) * t;
+
+		deck.chunk_pos += deck.step;
+		write++;
+		space--;
+	}
+
+	deck.write.store(write, std::memory_order_release);
+
+	// Published after the last frames so the mixer never drops the tail
+	if (ended) deck.ended.store(true, std::memory_order_release);
+}
+
+// Next chunk of the source as stereo, the last frame of the current chunk is
+// carried over so interpolation runs across the boundary. Loops rewind here
+bool MusicPlayer::DecodeChunk(MusicDeck& deck)
+{
+	if (deck.source_ended)
+		return false;
+
+	uint channels = deck.decoder.channels;
+	uint read = DecodeAudioFrames(deck.decoder, deck.decoded.data(), MUSIC_DECODE_FRAMES);
+
+	if (read == 0 && deck.loop)
+	{
+		RewindAudioDecoder(deck.decoder);
+		read = DecodeAudioFrames(deck.decoder, deck.decoded.data(), MUSIC_DECODE_FRAMES);
+	}
+
+	if (read == 0)
+	{
+		deck.source_ended = true;
+		return false;
+	}
+
+	uint carry = 0;
+	if (deck.chunk_frames > 0)
+	{
+		deck.chunk[0] = deck.chunk[(deck.chunk_frames - 1) * 2];
+		deck.chunk[1] = deck.chunk[(deck.chunk_frames - 1) * 2 + 1];
+		deck.chunk_pos -= deck.chunk_frames - 1;
+		carry = 1;
+	}
+
+	// Mono is doubled, past stereo only the front pair is kept
+	for (uint i = 0; i < read; ++i)
+	{
+		const float* src = &deck.decoded[i * channels];
+		float* dst = &deck.chunk[(carry + i) * 2];
+
+		dst[0] = src[0];
+		dst[1] = (channels > 1) ? src[1] : src[0];
+	}
+
+	deck.chunk_frames = carry + read;
+	return true;
+}
+
+// Only called once the mixer no longer reads the deck
+void MusicPlayer::ReleaseDeck(MusicDeck& deck)
+{
+	UnloadAudioDecoder(deck.decoder);
+
+	deck.decoder = AudioDecoder{ 0 };
+	deck.chunk_frames = 0;
+	deck.chunk_pos = 0.0;
+	deck.source_ended = false;
+	deck.ended = false;
+	deck.write = 0;
+	deck.read = 0;
+	deck.state.store(MUSIC_DECK_IDLE, std::memory_order_release);
+}
+
+// Audio thread -------------------------------------------------------
+
+void MusicPlayer::StreamCallback(void* buffer, unsigned int frames)
+{
+	if (active != NULL) active->Render((float*)buffer, frames);
+	else memset(buffer, 0, frames * 2 * sizeof(float));
+}
+
+void MusicPlayer::Render(float* out, uint frames)
+{
+	memset(out, 0, frames * 2 * sizeof(float));
+
+	float master = volume.load(std::memory_order_relaxed);
+
+	for (int d = 0; d < MUSIC_DECKS; ++d)
+	{
+		MusicDeck& deck = decks[d];
+		int state = deck.state.load(std::memory_order_acquire);
+
+		if (state == MUSIC_DECK_IDLE || state == MUSIC_DECK_DONE)
+		{
+			deck.seen_state = state;
+			continue;
+		}
+
+		if (state != deck.seen_state)
+		{
+			float fade = deck.fade_time.load(std::memory_order_relaxed);
+			float step = (fade > 0.0f) ? 1.0f / (fade * MUSIC_SAMPLE_RATE) : 1.0f;
+
+			if (state == MUSIC_DECK_PLAYING)
+			{
+				deck.gain = (fade > 0.0f) ? 0.0f : 1.0f;
+				deck.gain_step = step;
+			}
+			else
+			{
+				deck.gain_step = -step;
+			}
+
+			deck.seen_state = state;
+		}
+
+		bool ended = deck.ended.load(std::memory_order_acquire);
+		uint read = deck.read.load(std::memory_order_relaxed);
+		uint available = deck.write.load(std::memory_order_acquire) - read;
+		uint count = MIN(frames, available);
+
+		for (uint i = 0; i < count; ++i)
+		{
+			deck.gain += deck.gain_step;
+			if (deck.gain > 1.0f) deck.gain = 1.0f;
+			else if (deck.gain < 0.0f) deck.gain = 0.0f;
+
+			uint index = ((read + i) & (MUSIC_RING_FRAMES - 1)) * 2;
+			float gain = deck.gain * master;
+
+			out[i * 2] += deck.ring[index] * gain;
+			out[i * 2 + 1] += deck.ring[index + 1] * gain;
+		}
+
+		deck.read.store(read + count, std::memory_order_release);
+
+		bool faded = (state == MUSIC_DECK_FADING && deck.gain <= 0.0f);
+		bool drained = (ended && count == available);
+
+		if (faded || drained)
+		{
+			int expected = state;
+			if (deck.state.compare_exchange_strong(expected, MUSIC_DECK_DONE, std::memory_order_acq_rel))
+				deck.seen_state = MUSIC_DECK_DONE;
+		}
+	}
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include "Globals.h"
+#include "SpscQueue.h"
+#include "AudioBank.h"
+
+#include "raylib.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#define MUSIC_SAMPLE_RATE 44100
+#define MUSIC_DECKS 2				// outgoing and incoming track of a crossfade
+#define MUSIC_RING_FRAMES 131072	// ~3 s kept ahead per deck, covers loading the next track
+#define MUSIC_DECODE_FRAMES 4096	// source frames decoded per chunk
+#define MUSIC_MAX_CHANNELS 8
+#define MUSIC_FEED_INTERVAL_MS 10	// worker sleep between refills
+#define MUSIC_PATH_LENGTH 256
+
+enum MusicDeckState
+{
+	MUSIC_DECK_IDLE = 0,		// owned by the worker, empty
+	MUSIC_DECK_PLAYING,			// fading in or playing, both threads use it
+	MUSIC_DECK_FADING,			// fading out, both threads use it
+	MUSIC_DECK_DONE				// silent, the worker frees it
+};
+
+enum MusicRequestType
+{
+	MUSIC_REQUEST_PLAY,
+	MUSIC_REQUEST_STOP
+};
+
+struct MusicRequest
+{
+	MusicRequestType type = MUSIC_REQUEST_PLAY;
+	char path[MUSIC_PATH_LENGTH] = { 0 };
+	float fade_time = 0.0f;
+	bool loop = true;
+};
+
+// One track: decoded by the worker a chunk at a time, converted to stereo at
+// MUSIC_SAMPLE_RATE and streamed to the mixer through a ring of interleaved floats
+struct MusicDeck
+{
+	std::atomic<int> state{ MUSIC_DECK_IDLE };
+	std::atomic<float> fade_time{ 0.0f };
+	std::atomic<bool> ended{ false };		// no more frames will be written
+
+	std::vector<float> ring;
+	std::atomic<uint> write{ 0 };
+	std::atomic<uint> read{ 0 };
+
+	// Worker side
+	AudioDecoder decoder = { 0 };
+	std::vector<float> decoded;			// one chunk as the decoder returns it
+	std::vector<float> chunk;			// stereo, frame 0 is the last frame of the previous chunk
+	uint chunk_frames = 0;
+	double chunk_pos = 0.0;				// resampling position in chunk frames
+	double step = 1.0;					// source frames per output frame
+	bool source_ended = false;
+	bool loop = true;
+
+	// Audio thread side
+	float gain = 0.0f;
+	float gain_step = 0.0f;
+	int seen_state = MUSIC_DECK_IDLE;
+};
+
+// Music playback that never blocks the game thread: a worker thread loads and
+// decodes tracks and keeps each deck's ring filled, an AudioStream callback
+// mixes the decks and crossfades between them
+class MusicPlayer
+{
+public:
+	MusicPlayer();
+	~MusicPlayer();
+
+	bool Init(const AudioBank* bank);
+	void CleanUp();
+
+	// Game thread, both only queue the request
+	bool Play(const char* path, float fade_time, bool loop);
+	void Stop(float fade_time);
+
+	void SetVolume(float volume);
+
+private:
+	void WorkerLoop();
+	void StartDeck(const MusicRequest& request);
+	void FadeOutDecks(float fade_time);
+	void Feed(MusicDeck& deck);
+	bool DecodeChunk(MusicDeck& deck);
+	void ReleaseDeck(MusicDeck& deck);
+
+	static void StreamCallback(void* buffer, unsigned int frames);
+	void Render(float* out, uint frames);
+
+	static MusicPlayer* active;
+
+	const AudioBank* bank = NULL;
+
+	AudioStream stream;
+	std::thread worker;
+	std::atomic<bool> running{ false };
+	std::atomic<float> volume{ 1.0f };
+
+	SpscQueue<MusicRequest, 16> requests;
+	MusicRequest pending;
+	bool has_pending = false;
+
+	MusicDeck decks[MUSIC_DECKS];
+};
@@ -0,0 +1,208 @@
+#include "PerfCapture.h"
+
+#include <algorithm>
+#include <map>
+#include <stdio.h>
+#include <string.h>
+
+static const char* phase_names[PERF_PHASES] = { "pre_update", "update", "post_update" };
+
+PerfCapture::PerfCapture()
+{
+}
+
+PerfCapture::~PerfCapture()
+{
+}
+
+void PerfCapture::BeginRun(const char* name)
+{
+	if (capturing)
+		EndRun();
+
+	runs.emplace_back();
+	runs.back().name = name;
+
+	frames.clear();
+	frames.reserve(PERF_RESERVED_FRAMES);
+	MemoryTracker::ResetPeaks();
+	max_bodies = 0;
+	max_contacts = 0;
+	capturing = true;
+}
+
+void PerfCapture::AddFrame(const PerfFrame& frame, unsigned int bodies, unsigned int contacts)
+{
+	if (!capturing)
+		return;
+
+	frames.push_back(frame);
+	max_bodies = std::max(max_bodies, bodies);
+	max_contacts = std::max(max_contacts, contacts);
+
+	PerfRun& run = runs.back();
+	for (int tag = 0; tag < MEMORY_TAGS; ++tag)
+		run.max_live_bytes[tag] = std::max(run.max_live_bytes[tag], MemoryTracker::GetStats((MemoryTag)tag).live_bytes);
+}
+
+void PerfCapture::EndRun()
+{
+	if (!capturing)
+		return;
+
+	PerfRun& run = runs.back();
+	run.frames = (unsigned int)frames.size();
+	run.max_bodies = max_bodies;
+	run.max_contacts = max_contacts;
+
+	// BeginRun() restarted the peaks, a run does not inherit the ones before it
+	run.peak_memory = 0;
+	for (int tag = 0; tag < MEMORY_TAGS; ++tag)
+		run.peak_memory += MemoryTracker::GetStats((MemoryTag)tag).peak_bytes;
+
+	std::vector<double> values(frames.size());
+
+	for (size_t i = 0; i < frames.size(); ++i)
+	{
+		values[i] = frames[i].frame_ms;
+		if (values[i] > PERF_FRAME_BUDGET_MS) run.hitches++;
+		if (i >= PERF_ALLOC_WARMUP_FRAMES && frames[i].allocs > 0) run.alloc_frames++;
+	}
+	run.frame = Reduce(values);
+
+	for (int phase = 0; phase < PERF_PHASES; ++phase)
+	{
+		for (size_t i = 0; i < frames.size(); ++i)
+			values[i] = frames[i].phase_ms[phase];
+		run.phases[phase] = Reduce(values);
+	}
+
+	frames.clear();
+	capturing = false;
+}
+
+bool PerfCapture::IsCapturing() const
+{
+	return capturing;
+}
+
+const std::vector<PerfRun>& PerfCapture::GetRuns() const
+{
+	return runs;
+}
+
+bool PerfCapture::Save(const char* path) const
+{
+	FILE* file = fopen(path, "w");
+	if (file == NULL)
+		return false;
+
+	for (const PerfRun& run : runs)
+	{
+		const char* name = run.name.c_str();
+
+		fprintf(file, "%s frames %u\n", name, run.frames);
+		fprintf(file, "%s hitches %u\n", name, run.hitches);
+		fprintf(file, "%s frame_p50 %.4f\n%s frame_p95 %.4f\n%s frame_p99 %.4f\n%s frame_max %.4f\n",
+			name, run.frame.p50, name, run.frame.p95, name, run.frame.p99, name, run.frame.max);
+
+		for (int phase = 0; phase < PERF_PHASES; ++phase)
+		{
+			const PerfPercentiles& p = run.phases[phase];
+			fprintf(file, "%s %s_p50 %.4f\n%s %s_p95 %.4f\n%s %s_p99 %.4f\n%s %s_max %.4f\n",
+				name, phase_names[phase], p.p50, name, phase_names[phase], p.p95,
+				name, phase_names[phase], p.p99, name, phase_names[phase], p.max);
+		}
+
+		fprintf(file, "%s peak_memory %llu\n", name, run.peak_memory);
+		fprintf(file, "%s max_bodies %u\n", name, run.max_bodies);
+		fprintf(file, "%s max_contacts %u\n", name, run.max_contacts);
+		fprintf(file, "%s alloc_frames %u\n", name, run.alloc_frames);
+
+		for (int tag = 0; tag < MEMORY_TAGS; ++tag)
+			fprintf(file, "%s max_%s_bytes %llu\n", name, MemoryTracker::GetTagName((MemoryTag)tag), run.max_live_bytes[tag]);
+	}
+
+	fclose(file);
+	return true;
+}
+
+bool PerfCapture::Compare(const char* baseline_path) const
+{
+	FILE* file = fopen(baseline_path, "r");
+	if (file == NULL)
+	{
+		printf("Cannot open perf baseline: %s\n", baseline_path);
+		return false;
+	}
+
+	std::map<std::string, double> baseline;
+	char run[64], metric[64];
+	double value;
+
+	while (fscanf(file, "%63s %63s %lf", run, metric, &value) == 3)
+		baseline[std::string(run) + " " + metric] = value;
+
+	fclose(file);
+
+	// Compared through the same text the baseline was written with
+	const char* current_path = PERF_RESULTS_FILE;
+	if (!Save(current_path) || (file = fopen(current_path, "r")) == NULL)
+		return false;
+
+	bool ok = true;
+
+	while (fscanf(file, "%63s %63s %lf", run, metric, &value) == 3)
+	{
+		// Steady state allocations fail on their own, a baseline never allows them
+		bool steady_allocs = strcmp(metric, "alloc_frames") == 0;
+
+		auto it = baseline.find(std::string(run) + " " + metric);
+		if (it == baseline.end() && !steady_allocs)
+		{
+			printf("%-8s %-18s %14.3f  (not in baseline)\n", run, metric, value);
+			continue;
+		}
+
+		double base = (it != baseline.end()) ? it->second : 0.0;
+		double limit;
+
+		if (strcmp(metric, "frames") == 0)
+			limit = -1.0;			// depends on the frame rate, informative only
+		else if (strcmp(metric, "hitches") == 0)
+			limit = base + PERF_HITCH_SLACK;
+		else if (steady_allocs)
+			limit = 0.0;
+		else if (strcmp(metric, "peak_memory") == 0 || strncmp(metric, "max_", 4) == 0)
+			limit = base * (1.0 + PERF_COUNT_TOLERANCE);
+		else
+			limit = base * (1.0 + PERF_TIME_TOLERANCE) + PERF_TIME_SLACK_MS;
+
+		bool regressed = limit >= 0.0 && value > limit;
+		if (regressed) ok = false;
+
+		printf("%-8s %-18s %14.3f  base %14.3f  %s\n", run, metric, value, base, regressed ? "REGRESSED" : "ok");
+	}
+
+	fclose(file);
+	printf("Perf %s\n", ok ? "within tolerance" : "REGRESSED");
+
+	return ok;
+}
+
+PerfPercentiles PerfCapture::Reduce(std::vector<double>& values)
+{
+	PerfPercentiles result;
+	if (values.empty())
+		return result;
+
+	std::sort(values.begin(), values.end());
+
+	size_t last = values.size() - 1;
+	result.p50 = values[last * 50 / 100];
+	result.p95 = values[last * 95 / 100];
+	result.p99 = values[last * 99 / 100];
+	result.max = values[last];
+
+	return result;
+}
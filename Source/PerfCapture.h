@@ -0,0 +1,89 @@
+#pragma once
+
+#include "MemoryTracker.h"
+
+#include <vector>
+#include <string>
+
+#define PERF_RACE_FILE "Perf.input"			// input log inside each map folder
+#define PERF_RESULTS_FILE "perf_results.txt"
+#define PERF_FRAME_BUDGET_MS 16.7			// frames over this count as hitches
+
+// Allowed regression before Compare() fails: relative, plus an absolute slack
+// for times so sub-millisecond phases do not fail on noise
+#define PERF_TIME_TOLERANCE 0.15
+#define PERF_TIME_SLACK_MS 0.5
+#define PERF_COUNT_TOLERANCE 0.10
+#define PERF_HITCH_SLACK 2
+
+// Frames of a run that may still allocate (race setup, first contacts); any
+// allocation after them counts in alloc_frames, which allows no slack at all
+#define PERF_ALLOC_WARMUP_FRAMES 60
+#define PERF_RESERVED_FRAMES (60 * 60 * 5)	// five minutes at 60 fps, AddFrame() must not allocate either
+
+enum PerfPhase
+{
+	PERF_PRE_UPDATE = 0,		// state changes, physics steps, audio
+	PERF_UPDATE,				// game and UI logic, draw queueing
+	PERF_POST_UPDATE,			// render queue flush and present
+	PERF_PHASES
+};
+
+struct PerfFrame
+{
+	double frame_ms = 0.0;
+	double phase_ms[PERF_PHASES] = { 0.0, 0.0, 0.0 };
+	unsigned int allocs = 0;			// all memory tags
+};
+
+struct PerfPercentiles
+{
+	double p50 = 0.0;
+	double p95 = 0.0;
+	double p99 = 0.0;
+	double max = 0.0;
+};
+
+struct PerfRun
+{
+	std::string name;
+	unsigned int frames = 0;
+	unsigned int hitches = 0;
+	PerfPercentiles frame;
+	PerfPercentiles phases[PERF_PHASES];
+	unsigned long long peak_memory = 0;	// tracked bytes, the sum of every tag's peak during the run
+	unsigned int max_bodies = 0;
+	unsigned int max_contacts = 0;
+	unsigned int alloc_frames = 0;
+	unsigned long long max_live_bytes[MEMORY_TAGS] = { 0, 0, 0 };
+};
+
+// Frame time capture of the --perf harness. Every run keeps its raw frames
+// until EndRun() reduces them to percentiles. Results are saved as one
+// "run metric value" line each, which is also the baseline format
+class PerfCapture
+{
+public:
+	PerfCapture();
+	~PerfCapture();
+
+	void BeginRun(const char* name);
+	void AddFrame(const PerfFrame& frame, unsigned int bodies, unsigned int contacts);
+	void EndRun();
+	bool IsCapturing() const;
+
+	const std::vector<PerfRun>& GetRuns() const;
+	bool Save(const char* path) const;
+
+	// Prints every metric against the baseline, false if any is past its tolerance
+	bool Compare(const char* baseline_path) const;
+
+private:
+	static PerfPercentiles Reduce(std::vector<double>& values);
+
+	std::vector<PerfRun> runs;
+	std::vector<PerfFrame> frames;
+	bool capturing = false;
+	unsigned int max_bodies = 0;
+	unsigned int max_contacts = 0;
+};
@@ -0,0 +1,249 @@
+#include "Globals.h"
+#include "ModulePhysics.h"
+#include "PhysicsDebugDraw.h"
+
+#include <algorithm>
+#include <math.h>
+
+PhysicsDebugDraw::PhysicsDebugDraw()
+{
+	SetFlags(e_shapeBit);
+	offset = { 0.0f, 0.0f };
+}
+
+PhysicsDebugDraw::~PhysicsDebugDraw()
+{
+}
+
+void PhysicsDebugDraw::DrawWorld(b2World* world, const b2AABB& _view, Vector2 _offset)
+{
+	view = _view;
+	offset = _offset;
+
+	lines.clear();
+	fixtures.clear();
+
+	// Broad-phase query instead of walking every body, chains report one proxy per child
+	world->QueryAABB(this, view);
+
+	std::sort(fixtures.begin(), fixtures.end());
+	fixtures.erase(std::unique(fixtures.begin(), fixtures.end()), fixtures.end());
+
+	uint32 flags = GetFlags();
+
+	if (flags & e_shapeBit)
+	{
+		for (b2Fixture* f : fixtures)
+		{
+			b2Body* b = f->GetBody();
+
+			if (b->GetType() == b2_staticBody) DrawFixture(f, b2Color(0.5f, 0.9f, 0.5f));
+			else if (b->GetType() == b2_kinematicBody) DrawFixture(f, b2Color(0.5f, 0.5f, 0.9f));
+			else if (b->IsAwake() == false) DrawFixture(f, b2Color(0.6f, 0.6f, 0.6f));
+			else DrawFixture(f, b2Color(0.9f, 0.2f, 0.2f));
+		}
+	}
+
+	if (flags & e_jointBit)
+	{
+		for (b2Joint* j = world->GetJointList(); j; j = j->GetNext())
+		{
+			if (InView(j->GetAnchorA()) || InView(j->GetAnchorB()))
+				j->Draw(this);
+		}
+	}
+
+	if (flags & e_pairBit)
+	{
+		b2Color color(0.3f, 0.9f, 0.9f);
+
+		for (b2Contact* c = world->GetContactList(); c; c = c->GetNext())
+		{
+			if (!c->IsTouching()) continue;
+
+			b2WorldManifold manifold;
+			c->GetWorldManifold(&manifold);
+
+			for (int32 i = 0; i < c->GetManifold()->pointCount; ++i)
+			{
+				if (InView(manifold.points[i]))
+					DrawPoint(manifold.points[i], 6.0f, color);
+			}
+		}
+	}
+
+	if (flags & e_aabbBit)
+	{
+		b2Color color(0.9f, 0.3f, 0.9f);
+
+		for (b2Fixture* f : fixtures)
+		{
+			for (int32 i = 0; i < f->GetShape()->GetChildCount(); ++i)
+			{
+				if (b2TestOverlap(f->GetAABB(i), view))
+					DrawAABB(f->GetAABB(i), color);
+			}
+		}
+	}
+}
+
+const rlLine* PhysicsDebugDraw::GetLines() const
+{
+	return lines.data();
+}
+
+int PhysicsDebugDraw::GetLineCount() const
+{
+	return (int)lines.size();
+}
+
+int PhysicsDebugDraw::GetFixtureCount() const
+{
+	return (int)fixtures.size();
+}
+
+bool PhysicsDebugDraw::ReportFixture(b2Fixture* fixture)
+{
+	fixtures.push_back(fixture);
+	return true;
+}
+
+void PhysicsDebugDraw::DrawFixture(b2Fixture* fixture, const b2Color& color)
+{
+	const b2Transform& xf = fixture->GetBody()->GetTransform();
+
+	switch (fixture->GetType())
+	{
+	case b2Shape::e_circle:
+	{
+		b2CircleShape* circle = (b2CircleShape*)fixture->GetShape();
+		b2Vec2 center = b2Mul(xf, circle->m_p);
+		b2Vec2 axis = b2Mul(xf.q, b2Vec2(1.0f, 0.0f));
+
+		DrawSolidCircle(center, circle->m_radius, axis, color);
+	}
+	break;
+
+	case b2Shape::e_edge:
+	{
+		b2EdgeShape* edge = (b2EdgeShape*)fixture->GetShape();
+		DrawSegment(b2Mul(xf, edge->m_vertex1), b2Mul(xf, edge->m_vertex2), color);
+	}
+	break;
+
+	case b2Shape::e_chain:
+	{
+		// The track borders are long loops, only the edges whose proxy meets the view are drawn
+		b2ChainShape* chain = (b2ChainShape*)fixture->GetShape();
+		const b2Vec2* vertices = chain->m_vertices;
+
+		for (int32 i = 0; i < chain->GetChildCount(); ++i)
+		{
+			if (b2TestOverlap(fixture->GetAABB(i), view))
+				DrawSegment(b2Mul(xf, vertices[i]), b2Mul(xf, vertices[i + 1]), color);
+		}
+	}
+	break;
+
+	case b2Shape::e_polygon:
+	{
+		b2PolygonShape* poly = (b2PolygonShape*)fixture->GetShape();
+		b2Vec2 vertices[b2_maxPolygonVertices];
+
+		for (int32 i = 0; i < poly->m_count; ++i)
+			vertices[i] = b2Mul(xf, poly->m_vertices[i]);
+
+		DrawSolidPolygon(vertices, poly->m_count, color);
+	}
+	break;
+
+	default:
+		break;
+	}
+}
+
+void PhysicsDebugDraw::DrawAABB(const b2AABB& aabb, const b2Color& color)
+{
+	b2Vec2 vs[4];
+	vs[0].Set(aabb.lowerBound.x, aabb.lowerBound.y);
+	vs[1].Set(aabb.upperBound.x, aabb.lowerBound.y);
+	vs[2].Set(aabb.upperBound.x, aabb.upperBound.y);
+	vs[3].Set(aabb.lowerBound.x, aabb.upperBound.y);
+
+	DrawPolygon(vs, 4, color);
+}
+
+bool PhysicsDebugDraw::InView(const b2Vec2& p) const
+{
+	return p.x >= view.lowerBound.x && p.x <= view.upperBound.x && p.y >= view.lowerBound.y && p.y <= view.upperBound.y;
+}
+
+// b2Draw ---------------------------------------------------------------
+
+void PhysicsDebugDraw::DrawPolygon(const b2Vec2* vertices, int32 vertexCount, const b2Color& color)
+{
+	b2Vec2 prev = vertices[vertexCount - 1];
+
+	for (int32 i = 0; i < vertexCount; ++i)
+	{
+		DrawSegment(prev, vertices[i], color);
+		prev = vertices[i];
+	}
+}
+
+// Outlines only, a fill would break the single line batch
+void PhysicsDebugDraw::DrawSolidPolygon(const b2Vec2* vertices, int32 vertexCount, const b2Color& color)
+{
+	DrawPolygon(vertices, vertexCount, color);
+}
+
+void PhysicsDebugDraw::DrawCircle(const b2Vec2& center, float radius, const b2Color& color)
+{
+	const float step = 2.0f * b2_pi / DEBUG_CIRCLE_SEGMENTS;
+
+	b2Vec2 prev = center + b2Vec2(radius, 0.0f);
+	for (int i = 1; i <= DEBUG_CIRCLE_SEGMENTS; ++i)
+	{
+		b2Vec2 v = center + radius * b2Vec2(cosf(step * i), sinf(step * i));
+		DrawSegment(prev, v, color);
+		prev = v;
+	}
+}
+
+void PhysicsDebugDraw::DrawSolidCircle(const b2Vec2& center, float radius, const b2Vec2& axis, const b2Color& color)
+{
+	DrawCircle(center, radius, color);
+	DrawSegment(center, center + radius * axis, color);
+}
+
+void PhysicsDebugDraw::DrawSegment(const b2Vec2& p1, const b2Vec2& p2, const b2Color& color)
+{
+	rlLine line;
+	line.x0 = PIXELS_PER_METER * p1.x + offset.x;
+	line.y0 = PIXELS_PER_METER * p1.y + offset.y;
+	line.x1 = PIXELS_PER_METER * p2.x + offset.x;
+	line.y1 = PIXELS_PER_METER * p2.y + offset.y;
+	line.color[0] = (unsigned char)(color.r * 255.0f);
+	line.color[1] = (unsigned char)(color.g * 255.0f);
+	line.color[2] = (unsigned char)(color.b * 255.0f);
+	line.color[3] = (unsigned char)(color.a * 255.0f);
+
+	lines.push_back(line);
+}
+
+void PhysicsDebugDraw::DrawTransform(const b2Transform& xf)
+{
+	const float axis_scale = 0.4f;
+
+	DrawSegment(xf.p, xf.p + axis_scale * xf.q.GetXAxis(), b2Color(1.0f, 0.0f, 0.0f));
+	DrawSegment(xf.p, xf.p + axis_scale * xf.q.GetYAxis(), b2Color(0.0f, 1.0f, 0.0f));
+}
+
+// Points are drawn as a small cross, size is in pixels
+void PhysicsDebugDraw::DrawPoint(const b2Vec2& p, float size, const b2Color& color)
+{
+	float half = PIXEL_TO_METERS(size * 0.5f);
+
+	DrawSegment(p - b2Vec2(half, 0.0f), p + b2Vec2(half, 0.0f), color);
+	DrawSegment(p - b2Vec2(0.0f, half), p + b2Vec2(0.0f, half), color);
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "Globals.h"
+
+#include "box2d\box2d.h"
+#include "rlgl.h"
+
+#include <vector>
+
+#define DEBUG_CIRCLE_SEGMENTS 16
+
+// Box2D debug renderer: only fixtures overlapping the view are visited and
+// every shape ends up as lines in one array, drawn with a single bulk call
+class PhysicsDebugDraw : public b2Draw, public b2QueryCallback
+{
+public:
+	PhysicsDebugDraw();
+	~PhysicsDebugDraw();
+
+	// view is in meters, offset is the camera translation in pixels
+	void DrawWorld(b2World* world, const b2AABB& view, Vector2 offset);
+
+	const rlLine* GetLines() const;
+	int GetLineCount() const;
+	int GetFixtureCount() const;
+
+	// b2Draw
+	void DrawPolygon(const b2Vec2* vertices, int32 vertexCount, const b2Color& color) override;
+	void DrawSolidPolygon(const b2Vec2* vertices, int32 vertexCount, const b2Color& color) override;
+	void DrawCircle(const b2Vec2& center, float radius, const b2Color& color) override;
+	void DrawSolidCircle(const b2Vec2& center, float radius, const b2Vec2& axis, const b2Color& color) override;
+	void DrawSegment(const b2Vec2& p1, const b2Vec2& p2, const b2Color& color) override;
+	void DrawTransform(const b2Transform& xf) override;
+	void DrawPoint(const b2Vec2& p, float size, const b2Color& color) override;
+
+	// b2QueryCallback
+	bool ReportFixture(b2Fixture* fixture) override;
+
+private:
+	void DrawFixture(b2Fixture* fixture, const b2Color& color);
+	void DrawAABB(const b2AABB& aabb, const b2Color& color);
+	bool InView(const b2Vec2& p) const;
+
+	std::vector<b2Fixture*> fixtures;
+	std::vector<rlLine> lines;
+
+	b2AABB view;
+	Vector2 offset;
+};
@@ -0,0 +1,229 @@
+#include "Globals.h"
+#include "RaceReplay.h"
+
+#include <math.h>
+#include <stdio.h>
+
+RaceReplay::RaceReplay()
+{
+}
+
+RaceReplay::~RaceReplay()
+{
+}
+
+void RaceReplay::Begin(const std::vector<ReplayCar>& race_cars)
+{
+	Clear();
+	cars = race_cars;
+	last.assign(cars.size() * REPLAY_CHANNELS, 0);
+
+	// Deltas mostly take one byte, twice that covers the keyframes too
+	data.reserve(cars.size() * REPLAY_CHANNELS * REPLAY_RESERVED_FRAMES * 2);
+	index.reserve(REPLAY_RESERVED_FRAMES / REPLAY_KEYFRAME_FRAMES + 1);
+}
+
+void RaceReplay::Record(uint32 tick, const ReplayTransform* transforms)
+{
+	if (cars.empty() || tick % REPLAY_SAMPLE_TICKS != 0)
+		return;
+
+	bool keyframe = (frame_count % REPLAY_KEYFRAME_FRAMES) == 0;
+	if (keyframe)
+		index.push_back((uint32)data.size());
+
+	for (uint car = 0; car < cars.size(); ++car)
+	{
+		const ReplayTransform& transform = transforms[car];
+		int values[REPLAY_CHANNELS] = {
+			(int)lroundf(transform.x),
+			(int)lroundf(transform.y),
+			(int)lroundf(transform.angle * REPLAY_ANGLE_SCALE),
+			(int)lroundf(transform.steer * REPLAY_ANGLE_SCALE)
+		};
+
+		int* previous = &last[car * REPLAY_CHANNELS];
+		for (int channel = 0; channel < REPLAY_CHANNELS; ++channel)
+		{
+			WriteValue(keyframe ? values[channel] : values[channel] - previous[channel]);
+			previous[channel] = values[channel];
+		}
+	}
+
+	frame_count++;
+}
+
+void RaceReplay::WriteValue(int value)
+{
+	uint32 zigzag = ((uint32)value << 1) ^ (uint32)(value >> 31);
+
+	while (zigzag >= 0x80)
+	{
+		data.push_back((uchar)(zigzag | 0x80));
+		zigzag >>= 7;
+	}
+	data.push_back((uchar)zigzag);
+}
+
+bool RaceReplay::Save(const char* path) const
+{
+	if (IsEmpty())
+		return false;
+
+	FILE* file = fopen(path, "wb");
+	if (file == NULL)
+	{
+		LOG("Cannot write replay: %s", path);
+		return false;
+	}
+
+	uint32 header[6] = { REPLAY_MAGIC, REPLAY_VERSION, (uint32)cars.size(), frame_count, (uint32)index.size(), (uint32)data.size() };
+	fwrite(header, sizeof(header), 1, file);
+	fwrite(cars.data(), sizeof(ReplayCar), cars.size(), file);
+	fwrite(index.data(), sizeof(uint32), index.size(), file);
+	fwrite(data.data(), 1, data.size(), file);
+	fclose(file);
+
+	LOG("Replay saved: %s (%u frames, %u bytes)", path, frame_count, (uint)data.size());
+	return true;
+}
+
+void RaceReplay::Clear()
+{
+	cars.clear();
+	data.clear();
+	index.clear();
+	last.clear();
+	frame_count = 0;
+	decoded.clear();
+	decoded_frame = 0xFFFFFFFF;
+	decoded_offset = 0;
+}
+
+bool RaceReplay::IsEmpty() const
+{
+	return frame_count == 0;
+}
+
+uint32 RaceReplay::GetLength() const
+{
+	return (frame_count > 0) ? (frame_count - 1) * REPLAY_SAMPLE_TICKS : 0;
+}
+
+uint RaceReplay::GetCarCount() const
+{
+	return (uint)cars.size();
+}
+
+const ReplayCar& RaceReplay::GetCar(uint car) const
+{
+	return cars[car];
+}
+
+uint RaceReplay::GetByteSize() const
+{
+	return (uint)(data.size() + index.size() * sizeof(uint32));
+}
+
+// A varint is at most 5 bytes, reads stop at the end of the data
+int RaceReplay::ReadValue(uint& offset) const
+{
+	uint32 zigzag = 0;
+
+	for (int shift = 0; shift < 35 && offset < data.size(); shift += 7)
+	{
+		uchar byte = data[offset++];
+		zigzag |= (uint32)(byte & 0x7F) << shift;
+
+		if ((byte & 0x80) == 0)
+			break;
+	}
+
+	return (int)(zigzag >> 1) ^ -(int)(zigzag & 1);
+}
+
+// Continues from the cached frame when it is in the same keyframe span and not
+// ahead of the target, otherwise restarts at the keyframe
+const int* RaceReplay::DecodeFrame(uint32 frame)
+{
+	uint value_count = (uint)cars.size() * REPLAY_CHANNELS;
+	uint32 keyframe = frame / REPLAY_KEYFRAME_FRAMES;
+
+	bool reuse = decoded_frame != 0xFFFFFFFF && decoded_frame <= frame && decoded_frame / REPLAY_KEYFRAME_FRAMES == keyframe;
+
+	if (!reuse)
+	{
+		decoded.assign(value_count, 0);
+		decoded_offset = index[keyframe];
+		decoded_frame = keyframe * REPLAY_KEYFRAME_FRAMES;
+
+		for (uint i = 0; i < value_count; ++i)
+			decoded[i] = ReadValue(decoded_offset);
+	}
+
+	while (decoded_frame < frame)
+	{
+		for (uint i = 0; i < value_count; ++i)
+			decoded[i] += ReadValue(decoded_offset);
+
+		decoded_frame++;
+	}
+
+	return decoded.data();
+}
+
+// The frame after the cached one, leaving the cache where it is
+void RaceReplay::DecodeNextFrame(std::vector<int>& out) const
+{
+	uint32 frame = decoded_frame + 1;
+
+	if (frame % REPLAY_KEYFRAME_FRAMES == 0)
+	{
+		uint offset = index[frame / REPLAY_KEYFRAME_FRAMES];
+		for (uint i = 0; i < decoded.size(); ++i)
+			out[i] = ReadValue(offset);
+	}
+	else
+	{
+		uint offset = decoded_offset;
+		for (uint i = 0; i < decoded.size(); ++i)
+			out[i] = decoded[i] + ReadValue(offset);
+	}
+}
+
+void RaceReplay::Seek(float tick, std::vector<ReplayTransform>& out)
+{
+	out.resize(cars.size());
+	if (IsEmpty())
+		return;
+
+	float position = tick / (float)REPLAY_SAMPLE_TICKS;
+	if (position < 0.0f) position = 0.0f;
+	if (position > (float)(frame_count - 1)) position = (float)(frame_count - 1);
+
+	uint32 frame = (uint32)position;
+	float t = position - (float)frame;
+
+	const int* a = DecodeFrame(frame);
+
+	// The last frame interpolates with itself
+	next_values.resize(decoded.size());
+	if (frame + 1 < frame_count)
+		DecodeNextFrame(next_values);
+	else
+		next_values.assign(decoded.begin(), decoded.end());
+
+	const int* b = next_values.data();
+
+	for (uint car = 0; car < cars.size(); ++car)
+	{
+		const int* va = &a[car * REPLAY_CHANNELS];
+		const int* vb = &b[car * REPLAY_CHANNELS];
+
+		ReplayTransform& transform = out[car];
+		transform.x = va[REPLAY_X] + (vb[REPLAY_X] - va[REPLAY_X]) * t;
+		transform.y = va[REPLAY_Y] + (vb[REPLAY_Y] - va[REPLAY_Y]) * t;
+		transform.angle = (va[REPLAY_ANGLE] + (vb[REPLAY_ANGLE] - va[REPLAY_ANGLE]) * t) / REPLAY_ANGLE_SCALE;
+		transform.steer = (va[REPLAY_STEER] + (vb[REPLAY_STEER] - va[REPLAY_STEER]) * t) / REPLAY_ANGLE_SCALE;
+	}
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "Globals.h"
+
+#include <vector>
+
+#define REPLAY_FILE "last_race.replay"
+#define REPLAY_MAGIC 0x594C5052			// "RPLY"
+#define REPLAY_VERSION 1
+#define REPLAY_SAMPLE_TICKS 2			// stored at 30 Hz, the viewer interpolates
+#define REPLAY_KEYFRAME_FRAMES 30		// one full frame per second of race
+#define REPLAY_ANGLE_SCALE 1000.0f		// mrad
+#define REPLAY_RESERVED_FRAMES (180 * 30)	// three minutes reserved by Begin(), recording does not allocate
+
+enum ReplayChannel
+{
+	REPLAY_X = 0,		// pixels
+	REPLAY_Y,
+	REPLAY_ANGLE,
+	REPLAY_STEER,
+	REPLAY_CHANNELS
+};
+
+// Sizes needed to draw a car without its physics bodies
+struct ReplayCar
+{
+	int body_w = 0;
+	int body_h = 0;
+	int tire_w = 0;
+	int tire_h = 0;
+};
+
+struct ReplayTransform
+{
+	float x = 0.0f;			// pixels
+	float y = 0.0f;
+	float angle = 0.0f;		// radians
+	float steer = 0.0f;		// steerable wheels relative to the body
+};
+
+// State replay of a race: car transforms quantised to pixels and mrad, a full
+// keyframe every REPLAY_KEYFRAME_FRAMES and zigzag varint deltas in between.
+// The keyframe index makes any tick one keyframe plus a few deltas away
+class RaceReplay
+{
+public:
+	RaceReplay();
+	~RaceReplay();
+
+	// Recording
+	void Begin(const std::vector<ReplayCar>& race_cars);
+	void Record(uint32 tick, const ReplayTransform* transforms);
+
+	// The file is for offline tools, the results screen plays from memory
+	bool Save(const char* path) const;
+	void Clear();
+
+	// Playback
+	bool IsEmpty() const;
+	uint32 GetLength() const;			// ticks
+	uint GetCarCount() const;
+	const ReplayCar& GetCar(uint car) const;
+	uint GetByteSize() const;
+
+	// Interpolated transforms of every car at any tick, fractions included
+	void Seek(float tick, std::vector<ReplayTransform>& out);
+
+private:
+	void WriteValue(int value);
+	int ReadValue(uint& offset) const;
+	const int* DecodeFrame(uint32 frame);
+	void DecodeNextFrame(std::vector<int>& out) const;
+
+	std::vector<ReplayCar> cars;
+	std::vector<uchar> data;
+	std::vector<uint32> index;			// data offset of every keyframe
+	uint32 frame_count = 0;
+
+	std::vector<int> last;				// recorder: previous frame values
+
+	// Decoder cache, it stays on the frame Seek() starts from, so sequential
+	// playback only decodes the deltas of the frame after it
+	std::vector<int> decoded;
+	uint32 decoded_frame = 0xFFFFFFFF;
+	uint decoded_offset = 0;
+	std::vector<int> next_values;		// decoded_frame + 1, never cached
+};
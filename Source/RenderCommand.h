@@ -0,0 +1,38 @@
+#pragma once
+
+#include "Globals.h"
+
+// Layers are submitted back to front, one after the other
+enum RenderLayer
+{
+	LAYER_BACKGROUND = 0,	// track map
+	LAYER_WORLD,			// cars, tires and props
+	LAYER_DEBUG,			// physics and waypoint debug shapes
+	LAYER_UI,				// menus and HUD
+	LAYER_COUNT
+};
+
+enum RenderCommandType
+{
+	RENDER_TEXTURE = 0,
+	RENDER_TEXT,
+	RENDER_LINE,
+	RENDER_RECTANGLE,
+	RENDER_RECTANGLE_LINES,
+	RENDER_CIRCLE,
+	RENDER_LINES
+};
+
+// Compact draw request stored in the per-frame queue
+struct RenderCommand
+{
+	uchar type;
+	uchar layer;
+	Color tint;
+	Texture2D texture;		// 0 for plain shapes
+	Rectangle source;		// texture section
+	Rectangle dest;			// quad / rectangle, line (x, y)-(width, height), circle (x, y) radius width
+	Vector2 origin;
+	float rotation;			// line and rectangle lines thickness
+	uint payload;			// text, line run or retained text index
+};
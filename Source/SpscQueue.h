@@ -0,0 +1,47 @@
+#pragma once
+
+#include "Globals.h"
+
+#include <atomic>
+
+// Fixed size ring for one producer thread and one consumer thread.
+// Neither side ever blocks: Push() fails when full, Pop() when empty
+template <class T, uint N>
+class SpscQueue
+{
+	static_assert(N > 0 && (N & (N - 1)) == 0, "SpscQueue size must be a power of two");
+
+public:
+	// Producer side
+	bool Push(const T& item)
+	{
+		uint head = write.load(std::memory_order_relaxed);
+
+		if (head - read.load(std::memory_order_acquire) >= N)
+			return false;
+
+		items[head & (N - 1)] = item;
+		write.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Consumer side
+	bool Pop(T& item)
+	{
+		uint tail = read.load(std::memory_order_relaxed);
+
+		if (tail == write.load(std::memory_order_acquire))
+			return false;
+
+		item = items[tail & (N - 1)];
+		read.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+private:
+	T items[N];
+
+	// Kept on separate cache lines so both threads don't fight over one
+	alignas(64) std::atomic<uint> write{ 0 };
+	alignas(64) std::atomic<uint> read{ 0 };
+};
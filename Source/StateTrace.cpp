@@ -0,0 +1,211 @@
+#include "Globals.h"
+#include "StateTrace.h"
+
+#include "box2d\box2d.h"
+
+StateTrace::StateTrace()
+{
+}
+
+StateTrace::~StateTrace()
+{
+	Close();
+}
+
+bool StateTrace::Open(const char* path)
+{
+	Close();
+
+	file = fopen(path, "wb");
+	if (file == NULL)
+	{
+		LOG("Cannot write state trace: %s", path);
+		return false;
+	}
+
+	uint32 header[2] = { STATE_TRACE_MAGIC, STATE_TRACE_VERSION };
+	fwrite(header, sizeof(header), 1, file);
+
+	return true;
+}
+
+void StateTrace::Close()
+{
+	if (file != NULL)
+	{
+		fclose(file);
+		file = NULL;
+	}
+}
+
+bool StateTrace::IsOpen() const
+{
+	return file != NULL;
+}
+
+// Floats are hashed by their bits, any difference in the last ulp shows up
+void StateTrace::Record(uint32 tick, b2World* world, uint32 game_hash)
+{
+	if (file == NULL)
+		return;
+
+	body_hashes.clear();
+	uint64 world_hash = Hash(&game_hash, sizeof(game_hash));
+
+	for (b2Body* body = world->GetBodyList(); body != NULL; body = body->GetNext())
+	{
+		if (body->GetType() == b2_staticBody)
+			continue;
+
+		const b2Transform& transform = body->GetTransform();
+		float state[7] = {
+			transform.p.x, transform.p.y, transform.q.s, transform.q.c,
+			body->GetLinearVelocity().x, body->GetLinearVelocity().y, body->GetAngularVelocity()
+		};
+
+		uint64 hash = Hash(state, sizeof(state));
+		body_hashes.push_back(Fold(hash));
+		world_hash = Hash(&hash, sizeof(hash), world_hash);
+	}
+
+	StateTraceTick record;
+	record.tick = tick;
+	record.body_count = (uint32)body_hashes.size();
+	record.game_hash = game_hash;
+	record.padding = 0;
+	record.world_hash = world_hash;
+
+	fwrite(&record, sizeof(record), 1, file);
+	if (!body_hashes.empty()) fwrite(body_hashes.data(), sizeof(uint32), body_hashes.size(), file);
+}
+
+static long FileSize(FILE* file)
+{
+	fseek(file, 0, SEEK_END);
+	long size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	return size;
+}
+
+// The body hashes must fit in what is left of the file, checked before resizing
+static bool ReadTick(FILE* file, long file_size, StateTraceTick& record, std::vector<uint32>& bodies)
+{
+	if (fread(&record, sizeof(record), 1, file) != 1)
+		return false;
+
+	if ((uint64)record.body_count * sizeof(uint32) > (uint64)(file_size - ftell(file)))
+	{
+		printf("Truncated state trace at tick %u\n", record.tick);
+		return false;
+	}
+
+	bodies.resize(record.body_count);
+	return record.body_count == 0 || fread(bodies.data(), sizeof(uint32), bodies.size(), file) == bodies.size();
+}
+
+bool StateTrace::Compare(const char* path_a, const char* path_b)
+{
+	FILE* a = fopen(path_a, "rb");
+	FILE* b = fopen(path_b, "rb");
+
+	if (a == NULL || b == NULL)
+	{
+		printf("Cannot open %s\n", (a == NULL) ? path_a : path_b);
+		if (a != NULL) fclose(a);
+		if (b != NULL) fclose(b);
+		return false;
+	}
+
+	long size_a = FileSize(a);
+	long size_b = FileSize(b);
+
+	uint32 header_a[2] = { 0 };
+	uint32 header_b[2] = { 0 };
+	fread(header_a, sizeof(header_a), 1, a);
+	fread(header_b, sizeof(header_b), 1, b);
+
+	bool same = true;
+
+	if (header_a[0] != STATE_TRACE_MAGIC || header_b[0] != STATE_TRACE_MAGIC || header_a[1] != header_b[1])
+	{
+		printf("Not comparable state traces\n");
+		same = false;
+	}
+
+	StateTraceTick tick_a, tick_b;
+	std::vector<uint32> bodies_a, bodies_b;
+	uint32 ticks = 0;
+
+	while (same)
+	{
+		bool has_a = ReadTick(a, size_a, tick_a, bodies_a);
+		bool has_b = ReadTick(b, size_b, tick_b, bodies_b);
+
+		if (!has_a || !has_b)
+		{
+			if (has_a != has_b)
+			{
+				printf("Traces end at different ticks: %s stops after %u ticks\n", has_a ? path_b : path_a, ticks);
+				same = false;
+			}
+			break;
+		}
+
+		if (tick_a.tick != tick_b.tick)
+		{
+			printf("Tick numbers differ: %u vs %u\n", tick_a.tick, tick_b.tick);
+			same = false;
+		}
+		else if (tick_a.world_hash != tick_b.world_hash)
+		{
+			same = false;
+
+			if (tick_a.game_hash != tick_b.game_hash)
+				printf("Tick %u: race state (laps, waypoints, rng) diverges\n", tick_a.tick);
+
+			if (tick_a.body_count != tick_b.body_count)
+			{
+				printf("Tick %u: body count %u vs %u\n", tick_a.tick, tick_a.body_count, tick_b.body_count);
+			}
+			else
+			{
+				for (uint32 i = 0; i < tick_a.body_count; ++i)
+				{
+					if (bodies_a[i] != bodies_b[i])
+					{
+						printf("Tick %u: first diverging body is #%u (world body list order, static bodies skipped)\n", tick_a.tick, i);
+						break;
+					}
+				}
+			}
+		}
+
+		ticks++;
+	}
+
+	if (same)
+		printf("Traces match over %u ticks\n", ticks);
+
+	fclose(a);
+	fclose(b);
+	return same;
+}
+
+// FNV-1a
+uint64 StateTrace::Hash(const void* data, uint size, uint64 hash)
+{
+	const uchar* bytes = (const uchar*)data;
+
+	for (uint i = 0; i < size; ++i)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ULL;
+	}
+
+	return hash;
+}
+
+uint32 StateTrace::Fold(uint64 hash)
+{
+	return (uint32)(hash ^ (hash >> 32));
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "Globals.h"
+
+#include <stdio.h>
+#include <vector>
+
+#define STATE_TRACE_MAGIC 0x43525453		// "STRC"
+#define STATE_TRACE_VERSION 1
+
+class b2World;
+
+// Per tick fingerprint of the simulation: one hash per dynamic body plus the
+// race state, so two runs can be compared to find where they stop matching
+struct StateTraceTick
+{
+	uint32 tick;
+	uint32 body_count;
+	uint32 game_hash;
+	uint32 padding;
+	uint64 world_hash;
+};
+
+class StateTrace
+{
+public:
+	StateTrace();
+	~StateTrace();
+
+	bool Open(const char* path);
+	void Close();
+	bool IsOpen() const;
+
+	// Hashes transforms and velocities of every non static body, in world order
+	void Record(uint32 tick, b2World* world, uint32 game_hash);
+
+	// Prints the first tick and body where the traces differ, true when identical
+	static bool Compare(const char* path_a, const char* path_b);
+
+	static uint64 Hash(const void* data, uint size, uint64 hash = 14695981039346656037ULL);
+	static uint32 Fold(uint64 hash);
+
+private:
+	FILE* file = NULL;
+	std::vector<uint32> body_hashes;
+};
@@ -0,0 +1,194 @@
+#include "Globals.h"
+#include "Telemetry.h"
+
+#include <math.h>
+
+Telemetry::Telemetry()
+{
+}
+
+Telemetry::~Telemetry()
+{
+	Close();
+}
+
+bool Telemetry::Open(const char* path)
+{
+	Close();
+
+	file = fopen(path, "wb");
+	if (file == NULL)
+	{
+		LOG("Cannot write telemetry: %s", path);
+		return false;
+	}
+
+	uint32 header[2] = { TELEMETRY_MAGIC, TELEMETRY_VERSION };
+	fwrite(header, sizeof(header), 1, file);
+
+	for (TelemetryBlock& block : blocks)
+		block.values.resize(TELEMETRY_CHANNELS * TELEMETRY_MAX_CARS * TELEMETRY_BLOCK_TICKS);
+
+	quit = false;
+	back_ready = false;
+	writer = std::thread(&Telemetry::WriterLoop, this);
+
+	return true;
+}
+
+void Telemetry::Close()
+{
+	if (file == NULL)
+		return;
+
+	EndRace();
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		quit = true;
+	}
+	wake.notify_one();
+	writer.join();
+
+	fclose(file);
+	file = NULL;
+}
+
+bool Telemetry::IsOpen() const
+{
+	return file != NULL;
+}
+
+void Telemetry::BeginRace(uint cars)
+{
+	if (file == NULL)
+		return;
+
+	EndRace();
+
+	front->race = ++race;
+	front->first_tick = 0;
+	front->ticks = 0;
+	front->cars = MIN(cars, (uint)TELEMETRY_MAX_CARS);
+	recording = true;
+}
+
+void Telemetry::Record(uint32 tick, int car, const TelemetrySample& sample)
+{
+	if (!recording || car < 0 || (uint)car >= front->cars)
+		return;
+
+	if (front->ticks == 0)
+		front->first_tick = tick;
+
+	int* values = front->values.data();
+	uint column = (uint)car * TELEMETRY_BLOCK_TICKS + front->ticks;
+	uint stride = front->cars * TELEMETRY_BLOCK_TICKS;
+
+	values[TELEMETRY_X * stride + column] = (int)lroundf(sample.x * TELEMETRY_POSITION_SCALE);
+	values[TELEMETRY_Y * stride + column] = (int)lroundf(sample.y * TELEMETRY_POSITION_SCALE);
+	values[TELEMETRY_HEADING * stride + column] = (int)lroundf(sample.heading * TELEMETRY_ANGLE_SCALE);
+	values[TELEMETRY_SPEED * stride + column] = (int)lroundf(sample.speed * TELEMETRY_SPEED_SCALE);
+	values[TELEMETRY_SLIP * stride + column] = (int)lroundf(sample.slip * TELEMETRY_SPEED_SCALE);
+	values[TELEMETRY_STEER * stride + column] = (int)lroundf(sample.steer * TELEMETRY_ANGLE_SCALE);
+	values[TELEMETRY_WAYPOINT * stride + column] = sample.waypoint;
+	values[TELEMETRY_LAP * stride + column] = sample.lap;
+}
+
+void Telemetry::EndTick()
+{
+	if (!recording)
+		return;
+
+	if (++front->ticks == TELEMETRY_BLOCK_TICKS)
+		Submit();
+}
+
+void Telemetry::EndRace()
+{
+	if (!recording)
+		return;
+
+	if (front->ticks > 0)
+		Submit();
+
+	recording = false;
+}
+
+// Only waits if the writer has not finished the previous block, ~4 s ago
+void Telemetry::Submit()
+{
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		wake.wait(lock, [this] { return !back_ready; });
+
+		TelemetryBlock* full = front;
+		front = back;
+		back = full;
+		back_ready = true;
+	}
+	wake.notify_one();
+
+	front->race = back->race;
+	front->cars = back->cars;
+	front->first_tick = back->first_tick + back->ticks;
+	front->ticks = 0;
+}
+
+void Telemetry::WriterLoop()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+
+	while (true)
+	{
+		wake.wait(lock, [this] { return back_ready || quit; });
+
+		if (back_ready)
+		{
+			// The back block is not touched by the simulation until back_ready drops
+			lock.unlock();
+			Encode(*back);
+			lock.lock();
+
+			back_ready = false;
+			wake.notify_one();
+		}
+		else if (quit)
+		{
+			break;
+		}
+	}
+}
+
+// Block: header, then every column as zigzag varint deltas from the previous tick
+void Telemetry::Encode(const TelemetryBlock& block)
+{
+	encoded.clear();
+
+	for (uint channel = 0; channel < TELEMETRY_CHANNELS; ++channel)
+	{
+		for (uint car = 0; car < block.cars; ++car)
+		{
+			const int* column = &block.values[(channel * block.cars + car) * TELEMETRY_BLOCK_TICKS];
+			int previous = 0;
+
+			for (uint tick = 0; tick < block.ticks; ++tick)
+			{
+				int delta = column[tick] - previous;
+				previous = column[tick];
+
+				uint32 zigzag = ((uint32)delta << 1) ^ (uint32)(delta >> 31);
+				while (zigzag >= 0x80)
+				{
+					encoded.push_back((uchar)(zigzag | 0x80));
+					zigzag >>= 7;
+				}
+				encoded.push_back((uchar)zigzag);
+			}
+		}
+	}
+
+	uint32 header[5] = { block.race, block.first_tick, block.ticks, block.cars, (uint32)encoded.size() };
+	fwrite(header, sizeof(header), 1, file);
+	fwrite(encoded.data(), 1, encoded.size(), file);
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "Globals.h"
+
+#include <stdio.h>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#define TELEMETRY_MAGIC 0x4D4C4554		// "TELM"
+#define TELEMETRY_VERSION 1
+#define TELEMETRY_BLOCK_TICKS 256		// ~4 s of race per block
+#define TELEMETRY_MAX_CARS 64
+
+// Fixed point scales the channels are quantised with
+#define TELEMETRY_POSITION_SCALE 100.0f		// cm
+#define TELEMETRY_ANGLE_SCALE 10000.0f		// 0.1 mrad
+#define TELEMETRY_SPEED_SCALE 1000.0f		// mm/s
+
+enum TelemetryChannel
+{
+	TELEMETRY_X = 0,
+	TELEMETRY_Y,
+	TELEMETRY_HEADING,
+	TELEMETRY_SPEED,
+	TELEMETRY_SLIP,
+	TELEMETRY_STEER,
+	TELEMETRY_WAYPOINT,
+	TELEMETRY_LAP,
+	TELEMETRY_CHANNELS
+};
+
+// One car on one physics tick, in meters, radians and m/s
+struct TelemetrySample
+{
+	float x = 0.0f;
+	float y = 0.0f;
+	float heading = 0.0f;
+	float speed = 0.0f;
+	float slip = 0.0f;			// lateral speed
+	float steer = 0.0f;			// front wheel angle relative to the body
+	int waypoint = 0;
+	int lap = 0;
+};
+
+// Ticks of one race, stored column by column: values[(channel * cars + car) * TELEMETRY_BLOCK_TICKS + tick]
+struct TelemetryBlock
+{
+	uint32 race = 0;
+	uint32 first_tick = 0;
+	uint32 ticks = 0;
+	uint32 cars = 0;
+	std::vector<int> values;
+};
+
+// Per tick car telemetry written to disk by a background thread. The
+// simulation only quantises samples into the front block; full blocks are
+// swapped with the back one and delta + varint encoded by the writer
+class Telemetry
+{
+public:
+	Telemetry();
+	~Telemetry();
+
+	bool Open(const char* path);
+	void Close();
+	bool IsOpen() const;
+
+	void BeginRace(uint cars);
+	void Record(uint32 tick, int car, const TelemetrySample& sample);
+	void EndTick();
+	void EndRace();
+
+private:
+	void Submit();
+	void WriterLoop();
+	void Encode(const TelemetryBlock& block);
+
+	FILE* file = NULL;
+	std::thread writer;
+	std::mutex mutex;
+	std::condition_variable wake;
+	bool quit = false;
+	bool back_ready = false;
+
+	TelemetryBlock blocks[2];
+	TelemetryBlock* front = &blocks[0];
+	TelemetryBlock* back = &blocks[1];
+
+	std::vector<uchar> encoded;		// writer thread only
+	uint32 race = 0;
+	bool recording = false;
+};
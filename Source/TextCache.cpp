@@ -0,0 +1,333 @@
+#include "Globals.h"
+#include "TextCache.h"
+
+#include <string.h>
+
+static_assert((TEXT_CACHE_RUNS & (TEXT_CACHE_RUNS - 1)) == 0, "TEXT_CACHE_RUNS must be a power of two");
+
+TextCache::TextCache()
+{
+	runs.resize(TEXT_CACHE_RUNS);
+	for (TextRun& run : runs)
+	{
+		run.text.reserve(TEXT_RUN_RESERVED_CHARS);
+		run.quads.reserve(TEXT_RUN_RESERVED_CHARS);
+	}
+
+	free_runs.reserve(TEXT_CACHE_RUNS);
+	Clear();
+}
+
+TextCache::~TextCache()
+{
+}
+
+int TextCache::GetRun(Font font, const char* text, float size, float spacing)
+{
+	// Same fallback DrawTextEx() applies
+	if (font.texture.id == 0) font = GetFontDefault();
+
+	uint64 key = Hash(font.texture.id, size, spacing, text);
+
+	// Strings with the same hash share the probe sequence, the whole key is compared
+	for (uint slot = (uint)key & table_mask; table[slot] != -1; slot = (slot + 1) & table_mask)
+	{
+		TextRun& run = runs[table[slot]];
+
+		if (run.key == key && run.font_id == font.texture.id && run.size == size && run.spacing == spacing && run.text == text)
+		{
+			run.last_frame = frame;
+			return table[slot];
+		}
+	}
+
+	// Miss
+	int index;
+	if (free_runs.empty())
+	{
+		index = Recycle();
+	}
+	else
+	{
+		index = free_runs.back();
+		free_runs.pop_back();
+	}
+
+	TextRun& run = runs[index];
+	run.key = key;
+	run.used = true;
+	run.font_id = font.texture.id;
+	run.size = size;
+	run.spacing = spacing;
+	run.text = text;
+	run.last_frame = frame;
+
+	// Recycling may have shifted entries into the probe sequence, it starts again
+	Insert(index);
+
+	Layout(run, font);
+	built++;
+
+	return index;
+}
+
+const TextRun& TextCache::GetRunData(int run) const
+{
+	return runs[run];
+}
+
+Vector2 TextCache::Measure(Font font, const char* text, float size, float spacing)
+{
+	if (text == NULL || text[0] == '\0')
+		return Vector2{ 0.0f, 0.0f };
+
+	return runs[GetRun(font, text, size, spacing)].bounds;
+}
+
+void TextCache::EndFrame()
+{
+	for (int i = 0; i < (int)runs.size(); ++i)
+	{
+		TextRun& run = runs[i];
+
+		if (run.used && frame - run.last_frame > TEXT_CACHE_MAX_AGE)
+		{
+			Remove(i);
+			free_runs.push_back(i);
+		}
+	}
+
+	frame++;
+	built = 0;
+}
+
+// Strings and quads keep their capacity for the next run of the slot
+void TextCache::Clear()
+{
+	for (TextRun& run : runs)
+	{
+		run.used = false;
+		run.text.clear();
+		run.quads.clear();
+	}
+
+	free_runs.clear();
+	for (int i = (int)runs.size() - 1; i >= 0; --i)
+		free_runs.push_back(i);
+
+	table.assign(runs.size() * 2, -1);
+	table_mask = (uint)table.size() - 1;
+
+	run_count = 0;
+	built = 0;
+}
+
+uint TextCache::GetRunCount() const
+{
+	return run_count;
+}
+
+// The pool is full: takes the run unused for longest. When even that one was
+// drawn this frame its handle is still queued, so the pool grows instead
+int TextCache::Recycle()
+{
+	int oldest = 0;
+	for (int i = 1; i < (int)runs.size(); ++i)
+	{
+		if (runs[i].last_frame < runs[oldest].last_frame)
+			oldest = i;
+	}
+
+	if (runs[oldest].last_frame != frame)
+	{
+		Remove(oldest);
+		return oldest;
+	}
+
+	Grow();
+
+	int index = free_runs.back();
+	free_runs.pop_back();
+	return index;
+}
+
+// Doubles the pool and rebuilds the table, handles stay valid as they are indices
+void TextCache::Grow()
+{
+	uint count = (uint)runs.size();
+	LOG("Text cache: %u strings in one frame, the pool grows to %u", count, count * 2);
+
+	runs.resize(count * 2);
+	free_runs.reserve(count * 2);
+
+	for (int i = (int)count * 2 - 1; i >= (int)count; --i)
+	{
+		runs[i].text.reserve(TEXT_RUN_RESERVED_CHARS);
+		runs[i].quads.reserve(TEXT_RUN_RESERVED_CHARS);
+		free_runs.push_back(i);
+	}
+
+	table.assign(runs.size() * 2, -1);
+	table_mask = (uint)table.size() - 1;
+	run_count = 0;
+
+	for (int i = 0; i < (int)count; ++i)
+	{
+		if (runs[i].used)
+			Insert(i);
+	}
+}
+
+void TextCache::Insert(int index)
+{
+	uint slot = (uint)runs[index].key & table_mask;
+	while (table[slot] != -1)
+		slot = (slot + 1) & table_mask;
+
+	table[slot] = index;
+	run_count++;
+}
+
+// Frees the table slot with backward shift deletion, so probes never need tombstones
+void TextCache::Remove(int index)
+{
+	TextRun& run = runs[index];
+
+	uint hole = (uint)run.key & table_mask;
+	while (table[hole] != index)
+		hole = (hole + 1) & table_mask;
+
+	for (uint next = (hole + 1) & table_mask; table[next] != -1; next = (next + 1) & table_mask)
+	{
+		// An entry can fill the hole when the hole lies between its home slot and itself
+		uint home = (uint)runs[table[next]].key & table_mask;
+		if (((next - home) & table_mask) >= ((next - hole) & table_mask))
+		{
+			table[hole] = table[next];
+			hole = next;
+		}
+	}
+
+	table[hole] = -1;
+	run.used = false;
+	run.text.clear();
+	run.quads.clear();
+	run_count--;
+}
+
+uint TextCache::GetBuiltThisFrame() const
+{
+	return built;
+}
+
+// Mirrors DrawTextEx()/DrawTextCodepoint() for the quads and MeasureTextEx() for the bounds
+void TextCache::Layout(TextRun& run, const Font& font) const
+{
+	run.quads.clear();
+
+	const char* text = run.text.c_str();
+	int length = (int)run.text.size();
+
+	float scale = run.size / (float)font.baseSize;
+	float padding = (float)font.glyphPadding;
+	float tex_width = (float)font.texture.width;
+	float tex_height = (float)font.texture.height;
+
+	float offset_x = 0.0f;
+	float offset_y = 0.0f;
+
+	// MeasureTextEx() state
+	float line_width = 0.0f;
+	float max_width = 0.0f;
+	float height = run.size;
+	int line_chars = 0;
+	int max_chars = 0;
+
+	for (int i = 0; i < length;)
+	{
+		int bytes = 0;
+		int codepoint = GetCodepointNext(&text[i], &bytes);
+		int index = GetGlyphIndex(font, codepoint);
+		i += bytes;
+
+		const GlyphInfo& glyph = font.glyphs[index];
+		const Rectangle& rec = font.recs[index];
+
+		line_chars++;
+
+		if (codepoint == '\n')
+		{
+			offset_y += run.size + TEXT_LINE_SPACING;
+			offset_x = 0.0f;
+
+			max_width = MAX(max_width, line_width);
+			line_width = 0.0f;
+			line_chars = 0;
+			height += run.size + TEXT_LINE_SPACING;
+		}
+		else
+		{
+			if (codepoint != ' ' && codepoint != '\t')
+			{
+				float x = offset_x + glyph.offsetX * scale - padding * scale;
+				float y = offset_y + glyph.offsetY * scale - padding * scale;
+				float w = (rec.width + 2.0f * padding) * scale;
+				float h = (rec.height + 2.0f * padding) * scale;
+
+				rlQuad quad;
+				quad.x[0] = x;		quad.y[0] = y;
+				quad.x[1] = x;		quad.y[1] = y + h;
+				quad.x[2] = x + w;	quad.y[2] = y + h;
+				quad.x[3] = x + w;	quad.y[3] = y;
+
+				quad.u0 = (rec.x - padding) / tex_width;
+				quad.v0 = (rec.y - padding) / tex_height;
+				quad.u1 = (rec.x + rec.width + padding) / tex_width;
+				quad.v1 = (rec.y + rec.height + padding) / tex_height;
+
+				quad.color[0] = quad.color[1] = quad.color[2] = quad.color[3] = 255;
+
+				run.quads.push_back(quad);
+			}
+
+			if (glyph.advanceX == 0) offset_x += rec.width * scale + run.spacing;
+			else offset_x += glyph.advanceX * scale + run.spacing;
+
+			if (glyph.advanceX != 0) line_width += glyph.advanceX;
+			else line_width += rec.width + glyph.offsetX;
+		}
+
+		max_chars = MAX(max_chars, line_chars);
+	}
+
+	max_width = MAX(max_width, line_width);
+
+	run.bounds.x = max_width * scale + (float)((max_chars - 1) * run.spacing);
+	run.bounds.y = height;
+}
+
+// FNV-1a over the string, seeded with the font parameters
+uint64 TextCache::Hash(uint font_id, float size, float spacing, const char* text)
+{
+	uint64 hash = 14695981039346656037ULL;
+
+	uint32 bits[3];
+	bits[0] = font_id;
+	memcpy(&bits[1], &size, sizeof(float));
+	memcpy(&bits[2], &spacing, sizeof(float));
+
+	const uchar* data = (const uchar*)bits;
+	for (int i = 0; i < (int)sizeof(bits); ++i)
+	{
+		hash ^= data[i];
+		hash *= 1099511628211ULL;
+	}
+
+	for (const uchar* c = (const uchar*)text; *c != '\0'; ++c)
+	{
+		hash ^= *c;
+		hash *= 1099511628211ULL;
+	}
+
+	return hash;
+}
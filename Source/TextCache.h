@@ -0,0 +1,73 @@
+#pragma once
+
+#include "Globals.h"
+
+#include "rlgl.h"
+
+#include <vector>
+#include <string>
+
+#define TEXT_CACHE_MAX_AGE 120		// frames a run survives without being drawn or measured
+#define TEXT_CACHE_RUNS 512			// slot pool reserved up front, a power of two
+#define TEXT_RUN_RESERVED_CHARS 32	// chars and quads every slot reserves up front, HUD strings fit
+#define TEXT_LINE_SPACING 2			// raylib's default line spacing (SetTextLineSpacing is never called)
+
+// One laid out string: glyph quads relative to the text origin, ready for rlDrawQuads
+struct TextRun
+{
+	uint64 key = 0;
+	bool used = false;
+
+	uint font_id = 0;
+	float size = 0.0f;
+	float spacing = 0.0f;
+	std::string text;
+
+	std::vector<rlQuad> quads;	// white, tinted when submitted
+	Vector2 bounds = { 0.0f, 0.0f };	// same result as MeasureTextEx()
+
+	uint64 last_frame = 0;
+};
+
+// Caches text layout keyed by (font, size, spacing, string) so steady HUD
+// strings are laid out once and then only copied into the render batch.
+// Runs live in a slot pool found through a linear probing table, so strings
+// that change every frame (the race timer) recycle slots without allocating.
+// A run drawn this frame is never recycled, the pool doubles instead
+class TextCache
+{
+public:
+	TextCache();
+	~TextCache();
+
+	// Returns the run handle, laying the string out on a miss
+	// NOTE: Handles are valid until the next EndFrame()
+	int GetRun(Font font, const char* text, float size, float spacing);
+	const TextRun& GetRunData(int run) const;
+
+	Vector2 Measure(Font font, const char* text, float size, float spacing);
+
+	// Drops runs that were not used for TEXT_CACHE_MAX_AGE frames
+	void EndFrame();
+	void Clear();
+
+	uint GetRunCount() const;
+	uint GetBuiltThisFrame() const;
+
+private:
+	void Layout(TextRun& run, const Font& font) const;
+	int Recycle();
+	void Grow();
+	void Insert(int run);
+	void Remove(int run);
+	static uint64 Hash(uint font_id, float size, float spacing, const char* text);
+
+	std::vector<TextRun> runs;			// only resized by Grow()
+	std::vector<int> free_runs;
+	std::vector<int> table;				// run index or -1, twice the pool
+	uint table_mask = 0;
+
+	uint64 frame = 0;
+	uint run_count = 0;
+	uint built = 0;
+};
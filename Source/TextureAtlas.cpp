@@ -0,0 +1,192 @@
+#include "Globals.h"
+#include "TextureAtlas.h"
+
+#include <algorithm>
+
+TextureAtlas::TextureAtlas()
+{
+}
+
+TextureAtlas::~TextureAtlas()
+{
+}
+
+int TextureAtlas::Add(const char* path)
+{
+	if (built)
+	{
+		LOG("Cannot add sprite after the atlas is built: %s", path);
+		return -1;
+	}
+
+	// Same file requested twice shares the same sprite
+	for (int i = 0; i < (int)sprites.size(); ++i)
+	{
+		if (sprites[i].path == path)
+			return i;
+	}
+
+	Sprite sprite;
+	sprite.path = path;
+	sprite.image = LoadImage(path);
+
+	if (sprite.image.data == NULL)
+	{
+		LOG("Cannot load sprite image: %s", path);
+		return -1;
+	}
+
+	sprites.push_back(sprite);
+	return (int)sprites.size() - 1;
+}
+
+bool TextureAtlas::Build(int page_size)
+{
+	if (built)
+		return true;
+
+	LOG("Packing %d sprites into texture atlas", (int)sprites.size());
+
+	// Shelf packing: tallest sprites first so every shelf wastes as little height as possible
+	std::vector<int> order(sprites.size());
+	for (int i = 0; i < (int)order.size(); ++i) order[i] = i;
+
+	std::sort(order.begin(), order.end(), [this](int a, int b)
+		{
+			return sprites[a].image.height > sprites[b].image.height;
+		});
+
+	struct PageLayout
+	{
+		int width;
+		int height;
+		int cursor_x;
+		int shelf_y;
+		int shelf_height;
+	};
+
+	std::vector<PageLayout> layouts;
+	int current = -1;
+
+	for (int index : order)
+	{
+		Sprite& sprite = sprites[index];
+		int w = sprite.image.width + ATLAS_PADDING;
+		int h = sprite.image.height + ATLAS_PADDING;
+
+		// Sprites that do not fit a regular page get one of their own
+		if (w > page_size || h > page_size)
+		{
+			layouts.push_back({ sprite.image.width, sprite.image.height, 0, 0, 0 });
+			sprite.page = (int)layouts.size() - 1;
+			sprite.section = { 0.0f, 0.0f, (float)sprite.image.width, (float)sprite.image.height };
+			continue;
+		}
+
+		if (current != -1)
+		{
+			PageLayout& layout = layouts[current];
+
+			if (layout.cursor_x + w > layout.width)
+			{
+				// Open a new shelf below the current one
+				layout.shelf_y += layout.shelf_height;
+				layout.cursor_x = 0;
+				layout.shelf_height = 0;
+			}
+
+			if (layout.shelf_y + h > layout.height)
+				current = -1;
+		}
+
+		if (current == -1)
+		{
+			layouts.push_back({ page_size, page_size, 0, 0, 0 });
+			current = (int)layouts.size() - 1;
+		}
+
+		PageLayout& layout = layouts[current];
+		sprite.page = current;
+		sprite.section = { (float)layout.cursor_x, (float)layout.shelf_y, (float)sprite.image.width, (float)sprite.image.height };
+
+		layout.cursor_x += w;
+		layout.shelf_height = MAX(layout.shelf_height, h);
+	}
+
+	// Compose every page on CPU and upload it once
+	for (int p = 0; p < (int)layouts.size(); ++p)
+	{
+		Image page = GenImageColor(layouts[p].width, layouts[p].height, BLANK);
+
+		for (Sprite& sprite : sprites)
+		{
+			if (sprite.page != p) continue;
+
+			Rectangle src = { 0.0f, 0.0f, (float)sprite.image.width, (float)sprite.image.height };
+			ImageDraw(&page, sprite.image, src, sprite.section, WHITE);
+		}
+
+		Texture2D texture = LoadTextureFromImage(page);
+		UnloadImage(page);
+
+		LOG("Atlas page %d: %dx%d", p, texture.width, texture.height);
+		pages.push_back(texture);
+	}
+
+	for (Sprite& sprite : sprites)
+	{
+		UnloadImage(sprite.image);
+		sprite.image = Image{ 0 };
+	}
+
+	built = true;
+	return true;
+}
+
+void TextureAtlas::Unload()
+{
+	for (Texture2D& page : pages)
+	{
+		UnloadTexture(page);
+	}
+	pages.clear();
+
+	for (Sprite& sprite : sprites)
+	{
+		if (sprite.image.data != NULL) UnloadImage(sprite.image);
+	}
+	sprites.clear();
+
+	built = false;
+}
+
+bool TextureAtlas::IsBuilt() const
+{
+	return built;
+}
+
+int TextureAtlas::GetPageCount() const
+{
+	return (int)pages.size();
+}
+
+int TextureAtlas::GetSpriteCount() const
+{
+	return (int)sprites.size();
+}
+
+Texture2D TextureAtlas::GetTexture(int sprite) const
+{
+	if (!built || sprite < 0 || sprite >= (int)sprites.size())
+		return Texture2D{ 0 };
+
+	return pages[sprites[sprite].page];
+}
+
+Rectangle TextureAtlas::GetSection(int sprite) const
+{
+	if (sprite < 0 || sprite >= (int)sprites.size())
+		return Rectangle{ 0.0f, 0.0f, 0.0f, 0.0f };
+
+	return sprites[sprite].section;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "Globals.h"
+
+#include <vector>
+#include <string>
+
+#define ATLAS_PAGE_SIZE 1024
+#define ATLAS_PADDING 2
+
+// Packs small sprites into a few big texture pages so consecutive draws
+// share the same texture and rlgl can keep them in a single draw call
+class TextureAtlas
+{
+public:
+	TextureAtlas();
+	~TextureAtlas();
+
+	// Queue an image to be packed, returns the sprite handle (-1 on error)
+	// NOTE: Handles stay valid after Build(), sections are resolved there
+	int Add(const char* path);
+
+	bool Build(int page_size = ATLAS_PAGE_SIZE);
+	void Unload();
+
+	bool IsBuilt() const;
+	int GetPageCount() const;
+	int GetSpriteCount() const;
+
+	Texture2D GetTexture(int sprite) const;
+	Rectangle GetSection(int sprite) const;
+
+private:
+
+	struct Sprite
+	{
+		std::string path;
+		Image image;
+		int page = -1;
+		Rectangle section = { 0.0f, 0.0f, 0.0f, 0.0f };
+	};
+
+	std::vector<Sprite> sprites;
+	std::vector<Texture2D> pages;
+	bool built = false;
+};
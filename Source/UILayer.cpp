@@ -0,0 +1,210 @@
+#include "Globals.h"
+#include "UILayer.h"
+
+#include <string.h>
+
+UILayer::UILayer()
+{
+}
+
+UILayer::~UILayer()
+{
+}
+
+bool UILayer::BeginWidget(uint64 id, Rectangle bounds, uint64 state)
+{
+	if (recording != -1)
+	{
+		LOG("UI widget started while another one is recording, closing it");
+		EndWidget();
+	}
+
+	int index;
+	auto it = lookup.find(id);
+
+	if (it == lookup.end())
+	{
+		if (!free_widgets.empty())
+		{
+			index = free_widgets.back();
+			free_widgets.pop_back();
+		}
+		else
+		{
+			widgets.emplace_back();
+			index = (int)widgets.size() - 1;
+		}
+
+		UIWidget& widget = widgets[index];
+		widget.id = id;
+		widget.state = state;
+		widget.bounds = bounds;
+		widget.used = true;
+		widget.commands.clear();
+		widget.texts.clear();
+
+		lookup[id] = index;
+		AddDirty(bounds);
+	}
+	else
+	{
+		index = it->second;
+		UIWidget& widget = widgets[index];
+
+		// Same id twice in a frame keeps the first declaration
+		if (widget.last_frame == frame)
+			return false;
+
+		bool moved = memcmp(&widget.bounds, &bounds, sizeof(Rectangle)) != 0;
+
+		if (widget.state == state && !moved)
+		{
+			widget.last_frame = frame;
+			order.push_back(index);
+			return false;
+		}
+
+		AddDirty(widget.bounds);
+		if (moved) AddDirty(bounds);
+
+		widget.state = state;
+		widget.bounds = bounds;
+		widget.commands.clear();
+		widget.texts.clear();
+	}
+
+	widgets[index].last_frame = frame;
+	order.push_back(index);
+	recording = index;
+
+	return true;
+}
+
+void UILayer::EndWidget()
+{
+	recording = -1;
+}
+
+UIWidget* UILayer::GetRecording()
+{
+	return (recording != -1) ? &widgets[recording] : NULL;
+}
+
+// Widgets that were not declared this frame are gone, their area is dirty too
+const std::vector<Rectangle>& UILayer::CollectDirty()
+{
+	recording = -1;
+
+	for (int i = 0; i < (int)widgets.size(); ++i)
+	{
+		UIWidget& widget = widgets[i];
+
+		if (widget.used && widget.last_frame != frame)
+		{
+			AddDirty(widget.bounds);
+
+			lookup.erase(widget.id);
+			widget.used = false;
+			widget.commands.clear();
+			widget.texts.clear();
+			free_widgets.push_back(i);
+		}
+	}
+
+	if (full_redraw)
+	{
+		dirty.clear();
+		dirty.push_back(Rectangle{ 0.0f, 0.0f, (float)SCREEN_WIDTH, (float)SCREEN_HEIGHT });
+	}
+	else if (dirty.size() > UI_MAX_DIRTY_RECTS)
+	{
+		Rectangle merged = dirty[0];
+
+		for (const Rectangle& rect : dirty)
+		{
+			float x0 = MIN(merged.x, rect.x);
+			float y0 = MIN(merged.y, rect.y);
+			float x1 = MAX(merged.x + merged.width, rect.x + rect.width);
+			float y1 = MAX(merged.y + merged.height, rect.y + rect.height);
+			merged = Rectangle{ x0, y0, x1 - x0, y1 - y0 };
+		}
+
+		dirty.clear();
+		dirty.push_back(merged);
+	}
+
+	return dirty;
+}
+
+const std::vector<int>& UILayer::GetOrder() const
+{
+	return order;
+}
+
+const UIWidget& UILayer::GetWidget(int index) const
+{
+	return widgets[index];
+}
+
+void UILayer::EndFrame()
+{
+	order.clear();
+	dirty.clear();
+	full_redraw = false;
+	frame++;
+}
+
+void UILayer::Invalidate()
+{
+	full_redraw = true;
+}
+
+void UILayer::Clear()
+{
+	widgets.clear();
+	free_widgets.clear();
+	lookup.clear();
+	order.clear();
+	dirty.clear();
+	recording = -1;
+	full_redraw = true;
+}
+
+uint UILayer::GetWidgetCount() const
+{
+	return (uint)lookup.size();
+}
+
+// FNV-1a over the name and the bounds, enough to tell widgets of one screen apart
+uint64 UILayer::Hash(const char* name, Rectangle bounds)
+{
+	uint64 hash = 14695981039346656037ULL;
+
+	for (const uchar* c = (const uchar*)name; *c != '\0'; ++c)
+	{
+		hash ^= *c;
+		hash *= 1099511628211ULL;
+	}
+
+	const uchar* data = (const uchar*)&bounds;
+	for (int i = 0; i < (int)sizeof(Rectangle); ++i)
+	{
+		hash ^= data[i];
+		hash *= 1099511628211ULL;
+	}
+
+	return hash;
+}
+
+uint64 UILayer::Combine(uint64 hash, uint64 value)
+{
+	return (hash ^ value) * 1099511628211ULL + (hash >> 29);
+}
+
+void UILayer::AddDirty(Rectangle rect)
+{
+	if (rect.width <= 0.0f || rect.height <= 0.0f)
+		return;
+
+	dirty.push_back(rect);
+}
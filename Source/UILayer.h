@@ -0,0 +1,78 @@
+#pragma once
+
+#include "Globals.h"
+#include "RenderCommand.h"
+
+#include <vector>
+#include <string>
+#include <unordered_map>
+
+#define UI_MAX_DIRTY_RECTS 16		// past this the dirty rects are merged into one
+
+// Text of a retained widget, resolved against the text cache on replay
+struct UIWidgetText
+{
+	Font font;
+	float size;
+	float spacing;
+	std::string text;
+};
+
+// Retained widget: the draw commands recorded the last time its state changed
+struct UIWidget
+{
+	uint64 id = 0;
+	uint64 state = 0;
+	Rectangle bounds = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+	std::vector<RenderCommand> commands;
+	std::vector<UIWidgetText> texts;	// RENDER_TEXT payload indexes this
+
+	uint64 last_frame = 0;
+	bool used = false;
+};
+
+// Widget tree of the UI layer. Widgets are declared every frame with an id,
+// bounds and a state value; only new widgets, widgets whose state or bounds
+// changed and widgets that disappeared mark their area as dirty
+class UILayer
+{
+public:
+	UILayer();
+	~UILayer();
+
+	// Returns true when the widget has to record its draw calls again
+	bool BeginWidget(uint64 id, Rectangle bounds, uint64 state);
+	void EndWidget();
+
+	// Widget currently recording, NULL when draw calls go to the frame queue
+	UIWidget* GetRecording();
+
+	// Called once per frame before the cached layer is redrawn
+	const std::vector<Rectangle>& CollectDirty();
+	const std::vector<int>& GetOrder() const;
+	const UIWidget& GetWidget(int index) const;
+	void EndFrame();
+
+	void Invalidate();
+	void Clear();
+
+	uint GetWidgetCount() const;
+
+	static uint64 Hash(const char* name, Rectangle bounds);
+	static uint64 Combine(uint64 hash, uint64 value);
+
+private:
+	void AddDirty(Rectangle rect);
+
+	std::vector<UIWidget> widgets;
+	std::vector<int> free_widgets;
+	std::unordered_map<uint64, int> lookup;
+
+	std::vector<int> order;			// declaration order this frame
+	std::vector<Rectangle> dirty;
+
+	uint64 frame = 1;
+	int recording = -1;
+	bool full_redraw = true;
+};
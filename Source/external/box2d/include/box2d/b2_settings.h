@@ -96,6 +96,14 @@ struct B2_API b2JointUserData
 B2_API void* b2Alloc_Default(int32 size);
 B2_API void b2Free_Default(void* mem);
 
+typedef void* (*b2AllocFcn)(int32 size);
+typedef void (*b2FreeFcn)(void* mem);
+
+/// Route the default allocation functions through your own allocator without
+/// rebuilding b2Alloc/b2Free. Pass nullptr to go back to malloc/free.
+/// Set it before creating any world, memory must be freed by the allocator that returned it.
+B2_API void b2SetAllocator(b2AllocFcn allocFcn, b2FreeFcn freeFcn);
+
 /// Implement this function to use your own memory allocator.
 inline void* b2Alloc(int32 size)
 {
@@ -29,14 +29,34 @@
 
 b2Version b2_version = {2, 4, 0};
 
+static b2AllocFcn b2_allocFcn = nullptr;
+static b2FreeFcn b2_freeFcn = nullptr;
+
+void b2SetAllocator(b2AllocFcn allocFcn, b2FreeFcn freeFcn)
+{
+	b2_allocFcn = allocFcn;
+	b2_freeFcn = freeFcn;
+}
+
 // Memory allocators. Modify these to use your own allocator.
 void* b2Alloc_Default(int32 size)
 {
+	if (b2_allocFcn)
+	{
+		return b2_allocFcn(size);
+	}
+
 	return malloc(size);
 }
 
 void b2Free_Default(void* mem)
 {
+	if (b2_freeFcn)
+	{
+		b2_freeFcn(mem);
+		return;
+	}
+
 	free(mem);
 }
 
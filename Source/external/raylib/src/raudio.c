@@ -331,6 +331,23 @@ typedef enum {
     MUSIC_MODULE_MOD        // MOD module audio context
 } MusicContextType;
 
+#if defined(SUPPORT_FILEFORMAT_QOA)
+// QOA decoder context, used by AudioDecoder
+// NOTE: Frames are read one at a time, from a file or from caller owned memory
+typedef struct QoaDecoder {
+    FILE *file;                     // File to read frames from (NULL for memory)
+    const unsigned char *data;      // Encoded data (NULL for file)
+    unsigned int dataSize;          // Encoded data size
+    unsigned int offset;            // Position of the next frame
+    unsigned int firstFrame;        // Position of the first frame
+    qoa_desc qoa;                   // QOA header and LMS state
+    unsigned char *buffer;          // One encoded frame (file only)
+    short *samples;                 // One decoded frame
+    unsigned int sampleCount;       // Frames in samples
+    unsigned int samplePos;         // Frames of samples already returned
+} QoaDecoder;
+#endif
+
 // NOTE: Different logic is used when feeding data to the playback device
 // depending on whether data is streamed (Music vs Sound)
 typedef enum {
@@ -391,6 +408,7 @@ typedef struct AudioData {
         int defaultSize;            // Default audio buffer size for audio streams
     } Buffer;
     rAudioProcessor *mixedProcessor;
+    AudioCallback preMixCallback;   // Called on the audio thread before mixing, lock already held
 } AudioData;
 
 //----------------------------------------------------------------------------------
@@ -403,7 +421,8 @@ static AudioData AUDIO = {          // Global AUDIO context
     // standard double-buffering system, a 4096 samples buffer has been chosen, it should be enough
     // In case of music-stalls, just increase this number
     .Buffer.defaultSize = 0,
-    .mixedProcessor = NULL
+    .mixedProcessor = NULL,
+    .preMixCallback = NULL
 };
 
 //----------------------------------------------------------------------------------
@@ -1220,6 +1239,32 @@ void SetSoundPan(Sound sound, float pan)
     SetAudioBufferPan(sound.stream.buffer, pan);
 }
 
+// Play a sound, assuming the audio system mutex has been locked
+// NOTE: Only valid from the callback set with SetAudioPreMixCallback()
+void PlaySoundInLockedState(Sound sound)
+{
+    AudioBuffer *buffer = sound.stream.buffer;
+
+    if (buffer != NULL)
+    {
+        buffer->playing = true;
+        buffer->paused = false;
+        buffer->frameCursorPos = 0;
+    }
+}
+
+// Stop a sound, assuming the audio system mutex has been locked
+void StopSoundInLockedState(Sound sound)
+{
+    StopAudioBufferInLockedState(sound.stream.buffer);
+}
+
+// Set volume for a sound, assuming the audio system mutex has been locked
+void SetSoundVolumeInLockedState(Sound sound, float volume)
+{
+    if (sound.stream.buffer != NULL) sound.stream.buffer->volume = volume;
+}
+
 // Convert wave data to desired format
 void WaveFormat(Wave *wave, int sampleRate, int sampleSize, int channels)
 {
@@ -2085,6 +2130,316 @@ float GetMusicTimePlayed(Music music)
     return secondsPlayed;
 }
 
+#if defined(SUPPORT_FILEFORMAT_QOA)
+// Create QOA decoder context, file or data must be provided
+static QoaDecoder *LoadQoaDecoder(FILE *file, const unsigned char *data, unsigned int dataSize)
+{
+    unsigned char header[QOA_MIN_FILESIZE] = { 0 };
+    qoa_desc qoa = { 0 };
+    unsigned int firstFrame = 0;
+
+    if (file != NULL)
+    {
+        if (fread(header, QOA_MIN_FILESIZE, 1, file) == 1) firstFrame = qoa_decode_header(header, QOA_MIN_FILESIZE, &qoa);
+    }
+    else if (dataSize >= QOA_MIN_FILESIZE) firstFrame = qoa_decode_header(data, (int)dataSize, &qoa);
+
+    if ((firstFrame == 0) || (qoa.channels == 0) || (qoa.channels > QOA_MAX_CHANNELS)) return NULL;
+
+    unsigned int bufferSize = (file != NULL)? qoa_max_frame_size(&qoa) : 0;
+    unsigned int samplesSize = qoa.channels*QOA_FRAME_LEN*sizeof(short);
+
+    QoaDecoder *ctx = RL_CALLOC(1, sizeof(QoaDecoder) + bufferSize + samplesSize);
+    if (ctx == NULL) return NULL;
+
+    ctx->file = file;
+    ctx->data = data;
+    ctx->dataSize = dataSize;
+    ctx->offset = firstFrame;
+    ctx->firstFrame = firstFrame;
+    ctx->qoa = qoa;
+    ctx->buffer = (bufferSize > 0)? (unsigned char *)ctx + sizeof(QoaDecoder) : NULL;
+    ctx->samples = (short *)((unsigned char *)ctx + sizeof(QoaDecoder) + bufferSize);
+
+    if (file != NULL) fseek(file, firstFrame, SEEK_SET);
+
+    return ctx;
+}
+
+// Decode next QOA frame into ctx->samples, returns false at the end or on corrupt data
+static bool DecodeQoaFrame(QoaDecoder *ctx)
+{
+    const unsigned char *bytes = NULL;
+    unsigned int size = 0;
+
+    if (ctx->file != NULL)
+    {
+        size = (unsigned int)fread(ctx->buffer, 1, qoa_max_frame_size(&ctx->qoa), ctx->file);
+        bytes = ctx->buffer;
+    }
+    else if (ctx->offset < ctx->dataSize)
+    {
+        size = ctx->dataSize - ctx->offset;
+        bytes = ctx->data + ctx->offset;
+    }
+
+    // Frame header samples are checked against the samples buffer, qoa_decode_frame() only checks the slices
+    unsigned int frameSamples = (size >= 8)? ((unsigned int)bytes[4] << 8) | bytes[5] : 0;
+
+    unsigned int frameLength = 0;
+    unsigned int used = ((frameSamples > 0) && (frameSamples <= QOA_FRAME_LEN))? qoa_decode_frame(bytes, size, &ctx->qoa, ctx->samples, &frameLength) : 0;
+
+    // The file read may have gone past this frame
+    if ((ctx->file != NULL) && (size > used)) fseek(ctx->file, (long)used - (long)size, SEEK_CUR);
+
+    ctx->offset += used;
+    ctx->sampleCount = frameLength;
+    ctx->samplePos = 0;
+
+    return ((used > 0) && (frameLength > 0));
+}
+#endif
+
+// Load audio decoder from file
+AudioDecoder LoadAudioDecoder(const char *fileName)
+{
+    AudioDecoder decoder = { 0 };
+
+    if (false) { }
+#if defined(SUPPORT_FILEFORMAT_WAV)
+    else if (IsFileExtension(fileName, ".wav"))
+    {
+        drwav *ctxWav = RL_CALLOC(1, sizeof(drwav));
+
+        if (drwav_init_file(ctxWav, fileName, NULL))
+        {
+            decoder.ctxType = MUSIC_AUDIO_WAV;
+            decoder.ctxData = ctxWav;
+            decoder.sampleRate = ctxWav->sampleRate;
+            decoder.channels = ctxWav->channels;
+            decoder.frameCount = (unsigned int)ctxWav->totalPCMFrameCount;
+        }
+        else RL_FREE(ctxWav);
+    }
+#endif
+#if defined(SUPPORT_FILEFORMAT_OGG)
+    else if (IsFileExtension(fileName, ".ogg"))
+    {
+        stb_vorbis *ctxOgg = stb_vorbis_open_filename(fileName, NULL, NULL);
+
+        if (ctxOgg != NULL)
+        {
+            stb_vorbis_info info = stb_vorbis_get_info(ctxOgg);
+
+            decoder.ctxType = MUSIC_AUDIO_OGG;
+            decoder.ctxData = ctxOgg;
+            decoder.sampleRate = info.sample_rate;
+            decoder.channels = info.channels;
+            decoder.frameCount = (unsigned int)stb_vorbis_stream_length_in_samples(ctxOgg);
+        }
+    }
+#endif
+#if defined(SUPPORT_FILEFORMAT_QOA)
+    else if (IsFileExtension(fileName, ".qoa"))
+    {
+        FILE *file = fopen(fileName, "rb");
+        QoaDecoder *ctxQoa = (file != NULL)? LoadQoaDecoder(file, NULL, 0) : NULL;
+
+        if (ctxQoa != NULL)
+        {
+            decoder.ctxType = MUSIC_AUDIO_QOA;
+            decoder.ctxData = ctxQoa;
+            decoder.sampleRate = ctxQoa->qoa.samplerate;
+            decoder.channels = ctxQoa->qoa.channels;
+            decoder.frameCount = ctxQoa->qoa.samples;
+        }
+        else if (file != NULL) fclose(file);
+    }
+#endif
+    else TRACELOG(LOG_WARNING, "DECODER: [%s] File format not supported", fileName);
+
+    if (decoder.ctxData == NULL) TRACELOG(LOG_WARNING, "DECODER: [%s] Failed to load audio decoder", fileName);
+    else TRACELOG(LOG_INFO, "DECODER: [%s] Audio decoder loaded successfully (%i Hz, %i ch, %i frames)", fileName, decoder.sampleRate, decoder.channels, decoder.frameCount);
+
+    return decoder;
+}
+
+// Load audio decoder from data
+// WARNING: Data is not copied, it must stay valid until the decoder is unloaded
+AudioDecoder LoadAudioDecoderFromMemory(const char *fileType, const unsigned char *data, int dataSize)
+{
+    AudioDecoder decoder = { 0 };
+
+    if ((data == NULL) || (dataSize <= 0)) return decoder;
+
+    if (false) { }
+#if defined(SUPPORT_FILEFORMAT_WAV)
+    else if ((strcmp(fileType, ".wav") == 0) || (strcmp(fileType, ".WAV") == 0))
+    {
+        drwav *ctxWav = RL_CALLOC(1, sizeof(drwav));
+
+        if (drwav_init_memory(ctxWav, (const void *)data, dataSize, NULL))
+        {
+            decoder.ctxType = MUSIC_AUDIO_WAV;
+            decoder.ctxData = ctxWav;
+            decoder.sampleRate = ctxWav->sampleRate;
+            decoder.channels = ctxWav->channels;
+            decoder.frameCount = (unsigned int)ctxWav->totalPCMFrameCount;
+        }
+        else RL_FREE(ctxWav);
+    }
+#endif
+#if defined(SUPPORT_FILEFORMAT_OGG)
+    else if ((strcmp(fileType, ".ogg") == 0) || (strcmp(fileType, ".OGG") == 0))
+    {
+        stb_vorbis *ctxOgg = stb_vorbis_open_memory(data, dataSize, NULL, NULL);
+
+        if (ctxOgg != NULL)
+        {
+            stb_vorbis_info info = stb_vorbis_get_info(ctxOgg);
+
+            decoder.ctxType = MUSIC_AUDIO_OGG;
+            decoder.ctxData = ctxOgg;
+            decoder.sampleRate = info.sample_rate;
+            decoder.channels = info.channels;
+            decoder.frameCount = (unsigned int)stb_vorbis_stream_length_in_samples(ctxOgg);
+        }
+    }
+#endif
+#if defined(SUPPORT_FILEFORMAT_QOA)
+    else if ((strcmp(fileType, ".qoa") == 0) || (strcmp(fileType, ".QOA") == 0))
+    {
+        QoaDecoder *ctxQoa = LoadQoaDecoder(NULL, data, (unsigned int)dataSize);
+
+        if (ctxQoa != NULL)
+        {
+            decoder.ctxType = MUSIC_AUDIO_QOA;
+            decoder.ctxData = ctxQoa;
+            decoder.sampleRate = ctxQoa->qoa.samplerate;
+            decoder.channels = ctxQoa->qoa.channels;
+            decoder.frameCount = ctxQoa->qoa.samples;
+        }
+    }
+#endif
+    else TRACELOG(LOG_WARNING, "DECODER: Data format not supported");
+
+    if (decoder.ctxData == NULL) TRACELOG(LOG_WARNING, "DECODER: Failed to load audio decoder from data");
+
+    return decoder;
+}
+
+// Checks if an audio decoder is ready
+bool IsAudioDecoderReady(AudioDecoder decoder)
+{
+    return ((decoder.ctxData != NULL) &&    // Decoder context loaded
+            (decoder.sampleRate > 0) &&     // Valid sample rate
+            (decoder.channels > 0));        // Valid number of channels
+}
+
+// Unload audio decoder
+void UnloadAudioDecoder(AudioDecoder decoder)
+{
+    if (decoder.ctxData == NULL) return;
+
+    if (false) { }
+#if defined(SUPPORT_FILEFORMAT_WAV)
+    else if (decoder.ctxType == MUSIC_AUDIO_WAV)
+    {
+        drwav_uninit((drwav *)decoder.ctxData);
+        RL_FREE(decoder.ctxData);
+    }
+#endif
+#if defined(SUPPORT_FILEFORMAT_OGG)
+    else if (decoder.ctxType == MUSIC_AUDIO_OGG) stb_vorbis_close((stb_vorbis *)decoder.ctxData);
+#endif
+#if defined(SUPPORT_FILEFORMAT_QOA)
+    else if (decoder.ctxType == MUSIC_AUDIO_QOA)
+    {
+        QoaDecoder *ctxQoa = (QoaDecoder *)decoder.ctxData;
+        if (ctxQoa->file != NULL) fclose(ctxQoa->file);
+        RL_FREE(ctxQoa);
+    }
+#endif
+}
+
+// Decode interleaved 32bit float frames
+// NOTE: Returns less frames than requested only at the end of the data
+unsigned int DecodeAudioFrames(AudioDecoder decoder, float *frames, unsigned int frameCount)
+{
+    unsigned int frameCountRead = 0;
+
+    if ((decoder.ctxData == NULL) || (frames == NULL)) return 0;
+
+    switch (decoder.ctxType)
+    {
+    #if defined(SUPPORT_FILEFORMAT_WAV)
+        case MUSIC_AUDIO_WAV: frameCountRead = (unsigned int)drwav_read_pcm_frames_f32((drwav *)decoder.ctxData, frameCount, frames); break;
+    #endif
+    #if defined(SUPPORT_FILEFORMAT_OGG)
+        case MUSIC_AUDIO_OGG:
+        {
+            while (frameCountRead < frameCount)
+            {
+                int read = stb_vorbis_get_samples_float_interleaved((stb_vorbis *)decoder.ctxData, decoder.channels, frames + frameCountRead*decoder.channels, (frameCount - frameCountRead)*decoder.channels);
+                if (read <= 0) break;
+                frameCountRead += read;
+            }
+        } break;
+    #endif
+    #if defined(SUPPORT_FILEFORMAT_QOA)
+        case MUSIC_AUDIO_QOA:
+        {
+            QoaDecoder *ctxQoa = (QoaDecoder *)decoder.ctxData;
+
+            while (frameCountRead < frameCount)
+            {
+                if ((ctxQoa->samplePos == ctxQoa->sampleCount) && !DecodeQoaFrame(ctxQoa)) break;
+
+                unsigned int count = ctxQoa->sampleCount - ctxQoa->samplePos;
+                if (count > frameCount - frameCountRead) count = frameCount - frameCountRead;
+
+                const short *src = ctxQoa->samples + ctxQoa->samplePos*decoder.channels;
+                float *dst = frames + frameCountRead*decoder.channels;
+                for (unsigned int i = 0; i < count*decoder.channels; i++) dst[i] = src[i]/32768.0f;
+
+                ctxQoa->samplePos += count;
+                frameCountRead += count;
+            }
+        } break;
+    #endif
+        default: break;
+    }
+
+    return frameCountRead;
+}
+
+// Rewind audio decoder to the first frame
+void RewindAudioDecoder(AudioDecoder decoder)
+{
+    if (decoder.ctxData == NULL) return;
+
+    switch (decoder.ctxType)
+    {
+    #if defined(SUPPORT_FILEFORMAT_WAV)
+        case MUSIC_AUDIO_WAV: drwav_seek_to_first_pcm_frame((drwav *)decoder.ctxData); break;
+    #endif
+    #if defined(SUPPORT_FILEFORMAT_OGG)
+        case MUSIC_AUDIO_OGG: stb_vorbis_seek_start((stb_vorbis *)decoder.ctxData); break;
+    #endif
+    #if defined(SUPPORT_FILEFORMAT_QOA)
+        case MUSIC_AUDIO_QOA:
+        {
+            QoaDecoder *ctxQoa = (QoaDecoder *)decoder.ctxData;
+            ctxQoa->offset = ctxQoa->firstFrame;
+            ctxQoa->sampleCount = 0;
+            ctxQoa->samplePos = 0;
+            if (ctxQoa->file != NULL) fseek(ctxQoa->file, ctxQoa->firstFrame, SEEK_SET);
+        } break;
+    #endif
+        default: break;
+    }
+}
+
 // Load audio stream (to stream audio pcm data)
 AudioStream LoadAudioStream(unsigned int sampleRate, unsigned int sampleSize, unsigned int channels)
 {
@@ -2300,6 +2655,16 @@ void AttachAudioMixedProcessor(AudioCallback process)
     ma_mutex_unlock(&AUDIO.System.lock);
 }
 
+// Set callback run on the audio thread at the start of every mix, with the audio system mutex held
+// NOTE: Lets the program apply queued changes without locking from its own thread,
+// the callback receives the output buffer before anything is mixed into it
+void SetAudioPreMixCallback(AudioCallback callback)
+{
+    ma_mutex_lock(&AUDIO.System.lock);
+    AUDIO.preMixCallback = callback;
+    ma_mutex_unlock(&AUDIO.System.lock);
+}
+
 // Remove processor from audio pipeline
 void DetachAudioMixedProcessor(AudioCallback process)
 {
@@ -2493,6 +2858,8 @@ static void OnSendAudioDataToDevice(ma_device *pDevice, void *pFramesOut, const
     // This is unlikely to be necessary for this project, but may want to consider how you might want to avoid this
     ma_mutex_lock(&AUDIO.System.lock);
     {
+        if (AUDIO.preMixCallback != NULL) AUDIO.preMixCallback(pFramesOut, frameCount);
+
         for (AudioBuffer *audioBuffer = AUDIO.Buffer.first; audioBuffer != NULL; audioBuffer = audioBuffer->next)
         {
             // Ignore stopped or paused sounds
@@ -80,6 +80,7 @@
 #define RAYLIB_H
 
 #include <stdarg.h>     // Required for: va_list - Only used by TraceLogCallback
+#include <stddef.h>     // Required for: size_t - Only used by memory callbacks
 
 #define RAYLIB_VERSION_MAJOR 5
 #define RAYLIB_VERSION_MINOR 5
@@ -123,17 +124,18 @@
 
 // Allow custom memory allocators
 // NOTE: Require recompiling raylib sources
+// NOTE: Defaults go through the memory callbacks, see SetMemoryCallbacks()
 #ifndef RL_MALLOC
-    #define RL_MALLOC(sz)       malloc(sz)
+    #define RL_MALLOC(sz)       RLMalloc(sz)
 #endif
 #ifndef RL_CALLOC
-    #define RL_CALLOC(n,sz)     calloc(n,sz)
+    #define RL_CALLOC(n,sz)     RLCalloc(n,sz)
 #endif
 #ifndef RL_REALLOC
-    #define RL_REALLOC(ptr,sz)  realloc(ptr,sz)
+    #define RL_REALLOC(ptr,sz)  RLRealloc(ptr,sz)
 #endif
 #ifndef RL_FREE
-    #define RL_FREE(ptr)        free(ptr)
+    #define RL_FREE(ptr)        RLFree(ptr)
 #endif
 
 // NOTE: MSVC C++ compiler does not support compound literals (C99 feature)
@@ -314,6 +316,7 @@ typedef struct Font {
     Texture2D texture;      // Texture atlas containing the glyphs
     Rectangle *recs;        // Rectangles in texture for the glyphs
     GlyphInfo *glyphs;      // Glyphs info data
+    void *glyphLookup;      // Codepoint to glyph index table, built on load (NULL: linear search)
 } Font;
 
 // Camera, defines position/orientation in 3d space
@@ -478,6 +481,16 @@ typedef struct Music {
     void *ctxData;              // Audio context data, depends on type
 } Music;
 
+// AudioDecoder, decodes audio data on demand, no audio stream attached
+typedef struct AudioDecoder {
+    unsigned int sampleRate;    // Frequency (samples per second)
+    unsigned int channels;      // Number of channels (1-mono, 2-stereo, ...)
+    unsigned int frameCount;    // Total number of frames (considering channels)
+
+    int ctxType;                // Type of decoder context (audio filetype)
+    void *ctxData;              // Decoder context data, depends on type
+} AudioDecoder;
+
 // VrDeviceInfo, Head-Mounted-Display device parameters
 typedef struct VrDeviceInfo {
     int hResolution;                // Horizontal resolution in pixels
@@ -940,6 +953,9 @@ typedef unsigned char *(*LoadFileDataCallback)(const char *fileName, int *dataSi
 typedef bool (*SaveFileDataCallback)(const char *fileName, void *data, int dataSize);   // FileIO: Save binary data
 typedef char *(*LoadFileTextCallback)(const char *fileName);            // FileIO: Load text data
 typedef bool (*SaveFileTextCallback)(const char *fileName, char *text); // FileIO: Save text data
+typedef void *(*MemAllocCallback)(size_t size);                         // Memory: Allocate
+typedef void *(*MemReallocCallback)(void *ptr, size_t size);            // Memory: Reallocate
+typedef void (*MemFreeCallback)(void *ptr);                             // Memory: Free
 
 //------------------------------------------------------------------------------------
 // Global Variables Definition
@@ -1091,6 +1107,10 @@ RLAPI void SetTraceLogLevel(int logLevel);                        // Set the cur
 RLAPI void *MemAlloc(unsigned int size);                          // Internal memory allocator
 RLAPI void *MemRealloc(void *ptr, unsigned int size);             // Internal memory reallocator
 RLAPI void MemFree(void *ptr);                                    // Internal memory free
+RLAPI void *RLMalloc(size_t size);                                // RL_MALLOC() default, goes through the memory callbacks
+RLAPI void *RLCalloc(size_t count, size_t size);                  // RL_CALLOC() default, goes through the memory callbacks
+RLAPI void *RLRealloc(void *ptr, size_t size);                    // RL_REALLOC() default, goes through the memory callbacks
+RLAPI void RLFree(void *ptr);                                     // RL_FREE() default, goes through the memory callbacks
 
 // Set custom callbacks
 // WARNING: Callbacks setup is intended for advanced users
@@ -1099,6 +1119,7 @@ RLAPI void SetLoadFileDataCallback(LoadFileDataCallback callback); // Set custom
 RLAPI void SetSaveFileDataCallback(SaveFileDataCallback callback); // Set custom file binary data saver
 RLAPI void SetLoadFileTextCallback(LoadFileTextCallback callback); // Set custom file text data loader
 RLAPI void SetSaveFileTextCallback(SaveFileTextCallback callback); // Set custom file text data saver
+RLAPI void SetMemoryCallbacks(MemAllocCallback allocCallback, MemReallocCallback reallocCallback, MemFreeCallback freeCallback); // Set custom memory allocator (NULL restores stdlib)
 
 // Files management functions
 RLAPI unsigned char *LoadFileData(const char *fileName, int *dataSize); // Load file data as byte array (read)
@@ -1638,6 +1659,9 @@ RLAPI bool IsSoundPlaying(Sound sound);                               // Check i
 RLAPI void SetSoundVolume(Sound sound, float volume);                 // Set volume for a sound (1.0 is max level)
 RLAPI void SetSoundPitch(Sound sound, float pitch);                   // Set pitch for a sound (1.0 is base level)
 RLAPI void SetSoundPan(Sound sound, float pan);                       // Set pan for a sound (0.5 is center)
+RLAPI void PlaySoundInLockedState(Sound sound);                       // Play a sound, only from the pre-mix callback
+RLAPI void StopSoundInLockedState(Sound sound);                       // Stop a sound, only from the pre-mix callback
+RLAPI void SetSoundVolumeInLockedState(Sound sound, float volume);    // Set volume for a sound, only from the pre-mix callback
 RLAPI Wave WaveCopy(Wave wave);                                       // Copy a wave to a new wave
 RLAPI void WaveCrop(Wave *wave, int initFrame, int finalFrame);       // Crop a wave to defined frames range
 RLAPI void WaveFormat(Wave *wave, int sampleRate, int sampleSize, int channels); // Convert wave data to desired format
@@ -1662,6 +1686,15 @@ RLAPI void SetMusicPan(Music music, float pan);                       // Set pan
 RLAPI float GetMusicTimeLength(Music music);                          // Get music time length (in seconds)
 RLAPI float GetMusicTimePlayed(Music music);                          // Get current music time played (in seconds)
 
+// AudioDecoder management functions
+// NOTE: Supported formats: WAV, OGG, QOA. Frames are pulled in chunks, the whole file is never decoded at once
+RLAPI AudioDecoder LoadAudioDecoder(const char *fileName);           // Load audio decoder from file, data is read as it is decoded
+RLAPI AudioDecoder LoadAudioDecoderFromMemory(const char *fileType, const unsigned char *data, int dataSize); // Load audio decoder from data, data is NOT copied and must outlive the decoder
+RLAPI bool IsAudioDecoderReady(AudioDecoder decoder);                 // Checks if an audio decoder is ready
+RLAPI void UnloadAudioDecoder(AudioDecoder decoder);                  // Unload audio decoder
+RLAPI unsigned int DecodeAudioFrames(AudioDecoder decoder, float *frames, unsigned int frameCount); // Decode interleaved 32bit float frames, returns frames decoded (0 at the end)
+RLAPI void RewindAudioDecoder(AudioDecoder decoder);                  // Rewind audio decoder to the first frame
+
 // AudioStream management functions
 RLAPI AudioStream LoadAudioStream(unsigned int sampleRate, unsigned int sampleSize, unsigned int channels); // Load audio stream (to stream raw audio pcm data)
 RLAPI bool IsAudioStreamReady(AudioStream stream);                    // Checks if an audio stream is ready
@@ -1684,6 +1717,7 @@ RLAPI void DetachAudioStreamProcessor(AudioStream stream, AudioCallback processo
 
 RLAPI void AttachAudioMixedProcessor(AudioCallback processor); // Attach audio stream processor to the entire audio pipeline, receives the samples as 'float'
 RLAPI void DetachAudioMixedProcessor(AudioCallback processor); // Detach audio stream processor from the entire audio pipeline
+RLAPI void SetAudioPreMixCallback(AudioCallback callback); // Set callback run on the audio thread before every mix (audio lock held)
 
 #if defined(__cplusplus)
 }
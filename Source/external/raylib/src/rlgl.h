@@ -397,6 +397,22 @@ typedef struct rlDrawCall {
     //Matrix modelview;         // Modelview matrix for this draw -> Using RLGL.modelview by default
 } rlDrawCall;
 
+// Bulk quad, corners already in screen space (top-left, bottom-left, bottom-right, top-right)
+// NOTE: Used by rlDrawQuads(), only current rlgl transform is applied to it
+typedef struct rlQuad {
+    float x[4];                 // Corners position X
+    float y[4];                 // Corners position Y
+    float u0, v0, u1, v1;       // Normalized texture coordinates (top-left, bottom-right)
+    unsigned char color[4];     // Vertex color (RGBA), shared by the 4 corners
+} rlQuad;
+
+// Bulk line, end points already in screen space
+typedef struct rlLine {
+    float x0, y0;               // Start position
+    float x1, y1;               // End position
+    unsigned char color[4];     // Vertex color (RGBA), shared by both ends
+} rlLine;
+
 // rlRenderBatch type
 typedef struct rlRenderBatch {
     int bufferCount;            // Number of vertex buffers (multi-buffering support)
@@ -677,6 +693,11 @@ RLAPI bool rlIsStereoRenderEnabled(void);               // Check if stereo rende
 RLAPI void rlClearColor(unsigned char r, unsigned char g, unsigned char b, unsigned char a); // Clear color buffer with color
 RLAPI void rlClearScreenBuffers(void);                  // Clear used screen buffers (color and depth)
 RLAPI void rlCheckErrors(void);                         // Check and log OpenGL error codes
+RLAPI unsigned int rlLoadGpuTimer(void);                // Load a GPU timer query (GL_TIME_ELAPSED), 0 if not supported
+RLAPI void rlUnloadGpuTimer(unsigned int id);           // Unload GPU timer query
+RLAPI void rlBeginGpuTimer(unsigned int id);            // Start timing the GL commands issued from now on
+RLAPI void rlEndGpuTimer(void);                         // Stop the active GPU timer
+RLAPI bool rlGetGpuTimerResult(unsigned int id, double *seconds); // Get GPU timer result without waiting, false while pending
 RLAPI void rlSetBlendMode(int mode);                    // Set blending mode
 RLAPI void rlSetBlendFactors(int glSrcFactor, int glDstFactor, int glEquation); // Set blending mode factor and equation (using OpenGL factors)
 RLAPI void rlSetBlendFactorsSeparate(int glSrcRGB, int glDstRGB, int glSrcAlpha, int glDstAlpha, int glEqRGB, int glEqAlpha); // Set blending mode factors and equations separately (using OpenGL factors)
@@ -709,6 +730,8 @@ RLAPI void rlDrawRenderBatchActive(void);               // Update and draw inter
 RLAPI bool rlCheckRenderBatchLimit(int vCount);         // Check internal buffer overflow for a given number of vertex
 
 RLAPI void rlSetTexture(unsigned int id);               // Set current texture for render batch and check buffers limits
+RLAPI void rlDrawQuads(unsigned int textureId, const rlQuad *quads, int count); // Write quads straight into render batch (0 for default texture)
+RLAPI void rlDrawLines(const rlLine *lines, int count); // Write lines straight into render batch
 
 //------------------------------------------------------------------------------------------------------------------------
 
@@ -869,6 +892,11 @@ RLAPI void rlLoadDrawQuad(void);     // Load and draw a quad
 #include <string.h>                     // Required for: strcmp(), strlen() [Used in rlglInit(), on extensions loading]
 #include <math.h>                       // Required for: sqrtf(), sinf(), cosf(), floor(), log()
 
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 1))
+    #include <xmmintrin.h>              // Required for: SSE intrinsics [Used in rlDrawQuads()]
+    #define RLGL_BULK_SSE
+#endif
+
 //----------------------------------------------------------------------------------
 // Defines and Macros
 //----------------------------------------------------------------------------------
@@ -1593,6 +1621,214 @@ void rlColor3f(float x, float y, float z)
 
 #endif
 
+//----------------------------------------------------------------------------------
+// Module Functions Definition - Bulk primitives submission
+//----------------------------------------------------------------------------------
+#if defined(GRAPHICS_API_OPENGL_33) || defined(GRAPHICS_API_OPENGL_ES2)
+// Make current draw call match required mode and texture, same rules as rlBegin() and rlSetTexture()
+static void rlBeginBulk(int mode, unsigned int textureId)
+{
+    rlDrawCall *draw = &RLGL.currentBatch->draws[RLGL.currentBatch->drawCounter - 1];
+
+    if ((draw->mode != mode) || (draw->textureId != textureId))
+    {
+        if (draw->vertexCount > 0)
+        {
+            // Keep next draw aligned to 4 vertex, check rlBegin() for details
+            if (draw->mode == RL_LINES) draw->vertexAlignment = ((draw->vertexCount < 4)? draw->vertexCount : draw->vertexCount%4);
+            else if (draw->mode == RL_TRIANGLES) draw->vertexAlignment = ((draw->vertexCount < 4)? 1 : (4 - (draw->vertexCount%4)));
+            else draw->vertexAlignment = 0;
+
+            if (!rlCheckRenderBatchLimit(draw->vertexAlignment))
+            {
+                RLGL.State.vertexCounter += draw->vertexAlignment;
+                RLGL.currentBatch->drawCounter++;
+            }
+        }
+
+        if (RLGL.currentBatch->drawCounter >= RL_DEFAULT_BATCH_DRAWCALLS) rlDrawRenderBatch(RLGL.currentBatch);
+
+        draw = &RLGL.currentBatch->draws[RLGL.currentBatch->drawCounter - 1];
+        draw->mode = mode;
+        draw->vertexCount = 0;
+        draw->textureId = textureId;
+    }
+}
+
+// Get how many primitives of vCount vertex still fit in current buffer, flushing it if none does
+static int rlBulkCapacity(int vCount, int requested)
+{
+    int limit = RLGL.currentBatch->vertexBuffer[RLGL.currentBatch->currentBuffer].elementCount*4;
+    int available = (limit - 1 - RLGL.State.vertexCounter)/vCount;
+
+    if (available <= 0)
+    {
+        rlCheckRenderBatchLimit(vCount + 1);    // Restores current mode and texture after drawing
+        available = (limit - 1 - RLGL.State.vertexCounter)/vCount;
+    }
+
+    return (available < requested)? available : requested;
+}
+#endif
+
+// Write quads straight into current render batch
+// NOTE: Avoids per-vertex rlVertex3f() calls and limit checks, current transform is applied 4 corners at once
+void rlDrawQuads(unsigned int textureId, const rlQuad *quads, int count)
+{
+    if ((quads == NULL) || (count <= 0)) return;
+
+#if defined(GRAPHICS_API_OPENGL_33) || defined(GRAPHICS_API_OPENGL_ES2)
+    if (textureId == 0) textureId = RLGL.State.defaultTextureId;
+
+    rlBeginBulk(RL_QUADS, textureId);
+
+    const Matrix *mat = &RLGL.State.transform;
+    const bool transform = RLGL.State.transformRequired;
+    const float depth = RLGL.currentBatch->currentDepth;
+
+    int done = 0;
+    while (done < count)
+    {
+        int chunk = rlBulkCapacity(4, count - done);
+
+        rlVertexBuffer *buffer = &RLGL.currentBatch->vertexBuffer[RLGL.currentBatch->currentBuffer];
+        float *vertices = buffer->vertices + 3*RLGL.State.vertexCounter;
+        float *texcoords = buffer->texcoords + 2*RLGL.State.vertexCounter;
+        float *normals = buffer->normals + 3*RLGL.State.vertexCounter;
+        unsigned char *colors = buffer->colors + 4*RLGL.State.vertexCounter;
+
+        for (int i = 0; i < chunk; i++)
+        {
+            const rlQuad *q = &quads[done + i];
+            float tx[4], ty[4], tz[4];
+
+            if (transform)
+            {
+#if defined(RLGL_BULK_SSE)
+                __m128 x = _mm_loadu_ps(q->x);
+                __m128 y = _mm_loadu_ps(q->y);
+                __m128 z = _mm_set1_ps(depth);
+
+                _mm_storeu_ps(tx, _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(mat->m0)), _mm_mul_ps(y, _mm_set1_ps(mat->m4))), _mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(mat->m8)), _mm_set1_ps(mat->m12))));
+                _mm_storeu_ps(ty, _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(mat->m1)), _mm_mul_ps(y, _mm_set1_ps(mat->m5))), _mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(mat->m9)), _mm_set1_ps(mat->m13))));
+                _mm_storeu_ps(tz, _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(mat->m2)), _mm_mul_ps(y, _mm_set1_ps(mat->m6))), _mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(mat->m10)), _mm_set1_ps(mat->m14))));
+#else
+                for (int k = 0; k < 4; k++)
+                {
+                    tx[k] = mat->m0*q->x[k] + mat->m4*q->y[k] + mat->m8*depth + mat->m12;
+                    ty[k] = mat->m1*q->x[k] + mat->m5*q->y[k] + mat->m9*depth + mat->m13;
+                    tz[k] = mat->m2*q->x[k] + mat->m6*q->y[k] + mat->m10*depth + mat->m14;
+                }
+#endif
+            }
+            else
+            {
+                for (int k = 0; k < 4; k++) { tx[k] = q->x[k]; ty[k] = q->y[k]; tz[k] = depth; }
+            }
+
+            // Same corner order and texcoords as DrawTexturePro()
+            const float u[4] = { q->u0, q->u0, q->u1, q->u1 };
+            const float v[4] = { q->v0, q->v1, q->v1, q->v0 };
+
+            for (int k = 0; k < 4; k++)
+            {
+                vertices[0] = tx[k]; vertices[1] = ty[k]; vertices[2] = tz[k];
+                texcoords[0] = u[k]; texcoords[1] = v[k];
+                normals[0] = 0.0f; normals[1] = 0.0f; normals[2] = 1.0f;
+                colors[0] = q->color[0]; colors[1] = q->color[1]; colors[2] = q->color[2]; colors[3] = q->color[3];
+
+                vertices += 3; texcoords += 2; normals += 3; colors += 4;
+            }
+        }
+
+        RLGL.State.vertexCounter += 4*chunk;
+        RLGL.currentBatch->draws[RLGL.currentBatch->drawCounter - 1].vertexCount += 4*chunk;
+        done += chunk;
+    }
+
+    RLGL.currentBatch->currentDepth += (1.0f/20000.0f);
+#else
+    // Fallback to immediate calls
+    rlSetTexture(textureId);
+    rlBegin(RL_QUADS);
+    for (int i = 0; i < count; i++)
+    {
+        rlColor4ub(quads[i].color[0], quads[i].color[1], quads[i].color[2], quads[i].color[3]);
+        rlTexCoord2f(quads[i].u0, quads[i].v0); rlVertex2f(quads[i].x[0], quads[i].y[0]);
+        rlTexCoord2f(quads[i].u0, quads[i].v1); rlVertex2f(quads[i].x[1], quads[i].y[1]);
+        rlTexCoord2f(quads[i].u1, quads[i].v1); rlVertex2f(quads[i].x[2], quads[i].y[2]);
+        rlTexCoord2f(quads[i].u1, quads[i].v0); rlVertex2f(quads[i].x[3], quads[i].y[3]);
+    }
+    rlEnd();
+    rlSetTexture(0);
+#endif
+}
+
+// Write lines straight into current render batch
+void rlDrawLines(const rlLine *lines, int count)
+{
+    if ((lines == NULL) || (count <= 0)) return;
+
+#if defined(GRAPHICS_API_OPENGL_33) || defined(GRAPHICS_API_OPENGL_ES2)
+    rlBeginBulk(RL_LINES, RLGL.State.defaultTextureId);
+
+    const Matrix *mat = &RLGL.State.transform;
+    const bool transform = RLGL.State.transformRequired;
+    const float depth = RLGL.currentBatch->currentDepth;
+
+    int done = 0;
+    while (done < count)
+    {
+        int chunk = rlBulkCapacity(2, count - done);
+
+        rlVertexBuffer *buffer = &RLGL.currentBatch->vertexBuffer[RLGL.currentBatch->currentBuffer];
+        float *vertices = buffer->vertices + 3*RLGL.State.vertexCounter;
+        float *texcoords = buffer->texcoords + 2*RLGL.State.vertexCounter;
+        float *normals = buffer->normals + 3*RLGL.State.vertexCounter;
+        unsigned char *colors = buffer->colors + 4*RLGL.State.vertexCounter;
+
+        for (int i = 0; i < chunk; i++)
+        {
+            const rlLine *l = &lines[done + i];
+            const float px[2] = { l->x0, l->x1 };
+            const float py[2] = { l->y0, l->y1 };
+
+            for (int k = 0; k < 2; k++)
+            {
+                if (transform)
+                {
+                    vertices[0] = mat->m0*px[k] + mat->m4*py[k] + mat->m8*depth + mat->m12;
+                    vertices[1] = mat->m1*px[k] + mat->m5*py[k] + mat->m9*depth + mat->m13;
+                    vertices[2] = mat->m2*px[k] + mat->m6*py[k] + mat->m10*depth + mat->m14;
+                }
+                else { vertices[0] = px[k]; vertices[1] = py[k]; vertices[2] = depth; }
+
+                texcoords[0] = 0.0f; texcoords[1] = 0.0f;
+                normals[0] = 0.0f; normals[1] = 0.0f; normals[2] = 1.0f;
+                colors[0] = l->color[0]; colors[1] = l->color[1]; colors[2] = l->color[2]; colors[3] = l->color[3];
+
+                vertices += 3; texcoords += 2; normals += 3; colors += 4;
+            }
+        }
+
+        RLGL.State.vertexCounter += 2*chunk;
+        RLGL.currentBatch->draws[RLGL.currentBatch->drawCounter - 1].vertexCount += 2*chunk;
+        done += chunk;
+    }
+
+    RLGL.currentBatch->currentDepth += (1.0f/20000.0f);
+#else
+    rlBegin(RL_LINES);
+    for (int i = 0; i < count; i++)
+    {
+        rlColor4ub(lines[i].color[0], lines[i].color[1], lines[i].color[2], lines[i].color[3]);
+        rlVertex2f(lines[i].x0, lines[i].y0);
+        rlVertex2f(lines[i].x1, lines[i].y1);
+    }
+    rlEnd();
+#endif
+}
+
 //--------------------------------------------------------------------------------------
 // Module Functions Definition - OpenGL style functions (common to 1.1, 3.3+, ES2)
 //--------------------------------------------------------------------------------------
@@ -2037,6 +2273,65 @@ void rlClearScreenBuffers(void)
     //glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);     // Stencil buffer not used...
 }
 
+// Load a GPU timer query
+// NOTE: Timer queries are core in OpenGL 3.3, a 2.1 context may not provide them
+unsigned int rlLoadGpuTimer(void)
+{
+    unsigned int id = 0;
+#if defined(GRAPHICS_API_OPENGL_33)
+    if ((glGenQueries != NULL) && (glGetQueryObjectui64v != NULL)) glGenQueries(1, &id);
+#endif
+    return id;
+}
+
+// Unload GPU timer query
+void rlUnloadGpuTimer(unsigned int id)
+{
+#if defined(GRAPHICS_API_OPENGL_33)
+    if (id > 0) glDeleteQueries(1, &id);
+#endif
+}
+
+// Start timing the GL commands issued from now on
+// NOTE: Only one timer can be active at a time, the render batch should be flushed first
+void rlBeginGpuTimer(unsigned int id)
+{
+#if defined(GRAPHICS_API_OPENGL_33)
+    if (id > 0) glBeginQuery(GL_TIME_ELAPSED, id);
+#endif
+}
+
+// Stop the active GPU timer
+void rlEndGpuTimer(void)
+{
+#if defined(GRAPHICS_API_OPENGL_33)
+    glEndQuery(GL_TIME_ELAPSED);
+#endif
+}
+
+// Get GPU timer result without waiting, false while the GPU has not reached the end of it
+// NOTE: Read it one or more frames later, asking for it right away stalls like glFinish()
+bool rlGetGpuTimerResult(unsigned int id, double *seconds)
+{
+    bool ready = false;
+#if defined(GRAPHICS_API_OPENGL_33)
+    if (id > 0)
+    {
+        int available = 0;
+        glGetQueryObjectiv(id, GL_QUERY_RESULT_AVAILABLE, &available);
+
+        if (available)
+        {
+            unsigned long long elapsed = 0;
+            glGetQueryObjectui64v(id, GL_QUERY_RESULT, &elapsed);
+            *seconds = (double)elapsed/1e9;
+            ready = true;
+        }
+    }
+#endif
+    return ready;
+}
+
 // Check and log OpenGL error codes
 void rlCheckErrors(void)
 {
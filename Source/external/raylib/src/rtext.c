@@ -115,11 +115,22 @@
 #ifndef MAX_TEXTSPLIT_COUNT
     #define MAX_TEXTSPLIT_COUNT                  128        // Maximum number of substrings to split: TextSplit()
 #endif
+#ifndef GLYPH_LOOKUP_DIRECT_SIZE
+    #define GLYPH_LOOKUP_DIRECT_SIZE             256        // Codepoints resolved with a direct index: ASCII + Latin-1
+#endif
 
 //----------------------------------------------------------------------------------
 // Types and Structures Definition
 //----------------------------------------------------------------------------------
-//...
+// Glyph lookup table, stored in Font.glyphLookup
+// NOTE: Allocated as a single block, hash arrays follow the struct
+typedef struct GlyphLookup {
+    int fallback;                           // Glyph index returned for missing codepoints ('?' or 0)
+    int hashMask;                           // Hash capacity - 1, 0 when all codepoints fit the direct table
+    int *hashKeys;                          // Sparse codepoints (open addressing, -1 for empty slots)
+    int *hashValues;                        // Glyph index for every hash key
+    int direct[GLYPH_LOOKUP_DIRECT_SIZE];   // Glyph index for codepoints below GLYPH_LOOKUP_DIRECT_SIZE
+} GlyphLookup;
 
 //----------------------------------------------------------------------------------
 // Global variables
@@ -146,6 +157,9 @@ static GlyphInfo *LoadFontDataBDF(const unsigned char *fileData, int dataSize, i
 #endif
 static int textLineSpacing = 2;                 // Text vertical line spacing in pixels (between lines)
 
+static void *LoadGlyphLookup(const GlyphInfo *glyphs, int glyphCount);  // Build codepoint to glyph index table
+static unsigned int GetGlyphLookupHash(int codepoint);                  // Hash sparse codepoints
+
 #if defined(SUPPORT_DEFAULT_FONT)
 extern void LoadFontDefault(void);
 extern void UnloadFontDefault(void);
@@ -300,6 +314,7 @@ extern void LoadFontDefault(void)
     UnloadImage(imFont);
 
     defaultFont.baseSize = (int)defaultFont.recs[0].height;
+    defaultFont.glyphLookup = LoadGlyphLookup(defaultFont.glyphs, defaultFont.glyphCount);
 
     TRACELOG(LOG_INFO, "FONT: Default font loaded successfully (%i glyphs)", defaultFont.glyphCount);
 }
@@ -311,6 +326,7 @@ extern void UnloadFontDefault(void)
     UnloadTexture(defaultFont.texture);
     RL_FREE(defaultFont.glyphs);
     RL_FREE(defaultFont.recs);
+    RL_FREE(defaultFont.glyphLookup);
 }
 #endif      // SUPPORT_DEFAULT_FONT
 
@@ -515,6 +531,7 @@ Font LoadFontFromImage(Image image, Color key, int firstChar)
     UnloadImage(fontClear);     // Unload processed image once converted to texture
 
     font.baseSize = (int)font.recs[0].height;
+    font.glyphLookup = LoadGlyphLookup(font.glyphs, font.glyphCount);
 
     return font;
 }
@@ -567,6 +584,8 @@ Font LoadFontFromMemory(const char *fileType, const unsigned char *fileData, int
 
         UnloadImage(atlas);
 
+        font.glyphLookup = LoadGlyphLookup(font.glyphs, font.glyphCount);
+
         TRACELOG(LOG_INFO, "FONT: Data loaded successfully (%i pixel size | %i glyphs)", font.baseSize, font.glyphCount);
     }
     else font = GetFontDefault();
@@ -948,6 +967,7 @@ void UnloadFont(Font font)
         UnloadFontData(font.glyphs, font.glyphCount);
         UnloadTexture(font.texture);
         RL_FREE(font.recs);
+        RL_FREE(font.glyphLookup);
 
         TRACELOGD("FONT: Unloaded font data from RAM and VRAM");
     }
@@ -1334,6 +1354,28 @@ int GetGlyphIndex(Font font, int codepoint)
 {
     int index = 0;
 
+    // Fonts loaded by raylib carry a lookup table: direct index for ASCII/Latin-1, hash for the rest
+    if (font.glyphLookup != NULL)
+    {
+        const GlyphLookup *lookup = (const GlyphLookup *)font.glyphLookup;
+
+        if ((unsigned int)codepoint < GLYPH_LOOKUP_DIRECT_SIZE) return lookup->direct[codepoint];
+
+        if (lookup->hashMask > 0)
+        {
+            unsigned int slot = GetGlyphLookupHash(codepoint) & lookup->hashMask;
+
+            while (lookup->hashKeys[slot] != -1)
+            {
+                if (lookup->hashKeys[slot] == codepoint) return lookup->hashValues[slot];
+                slot = (slot + 1) & lookup->hashMask;
+            }
+        }
+
+        return lookup->fallback;
+    }
+
+    // Fonts filled by hand (no lookup table) keep the linear search
 #define SUPPORT_UNORDERED_CHARSET
 #if defined(SUPPORT_UNORDERED_CHARSET)
     int fallbackIndex = 0;      // Get index of fallback glyph '?'
@@ -2129,6 +2171,79 @@ int GetCodepointPrevious(const char *text, int *codepointSize)
 //----------------------------------------------------------------------------------
 // Module specific Functions Definition
 //----------------------------------------------------------------------------------
+// Build codepoint to glyph index table
+// NOTE: First glyph wins for repeated codepoints, missing ones resolve to '?' (or glyph 0)
+static void *LoadGlyphLookup(const GlyphInfo *glyphs, int glyphCount)
+{
+    if ((glyphs == NULL) || (glyphCount <= 0)) return NULL;
+
+    int fallback = -1;
+    int sparseCount = 0;
+
+    for (int i = 0; i < glyphCount; i++)
+    {
+        if ((fallback == -1) && (glyphs[i].value == 63)) fallback = i;
+        if ((unsigned int)glyphs[i].value >= GLYPH_LOOKUP_DIRECT_SIZE) sparseCount++;
+    }
+
+    if (fallback == -1) fallback = 0;
+
+    // Keep the hash at most half full so probes stay short
+    int capacity = 0;
+    if (sparseCount > 0)
+    {
+        capacity = 4;
+        while (capacity < sparseCount*2) capacity *= 2;
+    }
+
+    GlyphLookup *lookup = (GlyphLookup *)RL_MALLOC(sizeof(GlyphLookup) + 2*capacity*sizeof(int));
+    if (lookup == NULL) return NULL;
+
+    lookup->fallback = fallback;
+    lookup->hashMask = (capacity > 0)? capacity - 1 : 0;
+    lookup->hashKeys = (int *)(lookup + 1);
+    lookup->hashValues = lookup->hashKeys + capacity;
+
+    for (int i = 0; i < GLYPH_LOOKUP_DIRECT_SIZE; i++) lookup->direct[i] = -1;
+    for (int i = 0; i < capacity; i++) lookup->hashKeys[i] = -1;
+
+    for (int i = 0; i < glyphCount; i++)
+    {
+        int codepoint = glyphs[i].value;
+
+        if ((unsigned int)codepoint < GLYPH_LOOKUP_DIRECT_SIZE)
+        {
+            if (lookup->direct[codepoint] == -1) lookup->direct[codepoint] = i;
+        }
+        else if (codepoint > 0)
+        {
+            unsigned int slot = GetGlyphLookupHash(codepoint) & lookup->hashMask;
+
+            while ((lookup->hashKeys[slot] != -1) && (lookup->hashKeys[slot] != codepoint)) slot = (slot + 1) & lookup->hashMask;
+
+            if (lookup->hashKeys[slot] == -1)
+            {
+                lookup->hashKeys[slot] = codepoint;
+                lookup->hashValues[slot] = i;
+            }
+        }
+    }
+
+    // Resolve misses at build time, the direct path is then a single load
+    for (int i = 0; i < GLYPH_LOOKUP_DIRECT_SIZE; i++)
+    {
+        if (lookup->direct[i] == -1) lookup->direct[i] = fallback;
+    }
+
+    return lookup;
+}
+
+// Hash sparse codepoints (Fibonacci hashing)
+static unsigned int GetGlyphLookupHash(int codepoint)
+{
+    return ((unsigned int)codepoint*2654435769u) >> 7;
+}
+
 #if defined(SUPPORT_FILEFORMAT_FNT) || defined(SUPPORT_FILEFORMAT_BDF)
 // Read a line from memory
 // REQUIRES: memcpy()
@@ -2300,6 +2415,8 @@ static Font LoadBMFont(const char *fileName)
     UnloadImage(fullFont);
     UnloadFileText(fileText);
 
+    font.glyphLookup = LoadGlyphLookup(font.glyphs, font.glyphCount);
+
     if (font.texture.id == 0)
     {
         UnloadFont(font);
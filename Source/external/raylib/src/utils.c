@@ -45,9 +45,10 @@
 #endif
 
 #include <stdlib.h>                     // Required for: exit()
+#include <stdint.h>                     // Required for: SIZE_MAX
 #include <stdio.h>                      // Required for: FILE, fopen(), fseek(), ftell(), fread(), fwrite(), fprintf(), vprintf(), fclose()
 #include <stdarg.h>                     // Required for: va_list, va_start(), va_end()
-#include <string.h>                     // Required for: strcpy(), strcat()
+#include <string.h>                     // Required for: strcpy(), strcat(), memset()
 
 //----------------------------------------------------------------------------------
 // Defines and Macros
@@ -67,6 +68,10 @@ static SaveFileDataCallback saveFileData = NULL;    // SaveFileText callback fun
 static LoadFileTextCallback loadFileText = NULL;    // LoadFileText callback function pointer
 static SaveFileTextCallback saveFileText = NULL;    // SaveFileText callback function pointer
 
+static MemAllocCallback memAlloc = NULL;            // RL_MALLOC callback function pointer
+static MemReallocCallback memRealloc = NULL;        // RL_REALLOC callback function pointer
+static MemFreeCallback memFree = NULL;              // RL_FREE callback function pointer
+
 //----------------------------------------------------------------------------------
 // Functions to set internal callbacks
 //----------------------------------------------------------------------------------
@@ -76,6 +81,15 @@ void SetSaveFileDataCallback(SaveFileDataCallback callback) { saveFileData = cal
 void SetLoadFileTextCallback(LoadFileTextCallback callback) { loadFileText = callback; }  // Set custom file text loader
 void SetSaveFileTextCallback(SaveFileTextCallback callback) { saveFileText = callback; }  // Set custom file text saver
 
+// Set custom memory allocator
+// NOTE: Set it before any raylib call, memory must be freed by the allocator that returned it
+void SetMemoryCallbacks(MemAllocCallback allocCallback, MemReallocCallback reallocCallback, MemFreeCallback freeCallback)
+{
+    memAlloc = allocCallback;
+    memRealloc = reallocCallback;
+    memFree = freeCallback;
+}
+
 
 #if defined(PLATFORM_ANDROID)
 static AAssetManager *assetManager = NULL;          // Android assets manager pointer
@@ -179,6 +193,43 @@ void MemFree(void *ptr)
     RL_FREE(ptr);
 }
 
+// RL_MALLOC() default
+void *RLMalloc(size_t size)
+{
+    if (memAlloc) return memAlloc(size);
+    return malloc(size);
+}
+
+// RL_CALLOC() default
+void *RLCalloc(size_t count, size_t size)
+{
+    if (memAlloc)
+    {
+        // calloc() fails on an overflowing count*size, the callback would get the wrapped size
+        if ((size != 0) && (count > SIZE_MAX/size)) return NULL;
+
+        void *ptr = memAlloc(count*size);
+        if (ptr != NULL) memset(ptr, 0, count*size);
+        return ptr;
+    }
+
+    return calloc(count, size);
+}
+
+// RL_REALLOC() default
+void *RLRealloc(void *ptr, size_t size)
+{
+    if (memRealloc) return memRealloc(ptr, size);
+    return realloc(ptr, size);
+}
+
+// RL_FREE() default
+void RLFree(void *ptr)
+{
+    if (memFree) memFree(ptr);
+    else free(ptr);
+}
+
 // Load data from file into a buffer
 unsigned char *LoadFileData(const char *fileName, int *dataSize)
 {